@@ -0,0 +1,64 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include "program.h"
+#include "evaluator.h"
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct DatasetOptions {
+    std::string path;
+    std::vector<std::string> columns;   // binary files only; CSV uses its header
+    bool binary;
+    unsigned threads;
+    size_t chunkBytes;
+
+    DatasetOptions() : binary(false), threads(0), chunkBytes(4 << 20) {}
+};
+
+// Slot values and row errors of one block of rows
+struct DatasetBlock {
+    std::vector<std::vector<Value>> values;
+    std::vector<std::vector<uint8_t>> status;
+    std::vector<SlotColumn> columns;
+};
+
+// Applies a program to every row of a CSV or raw column-major float64 file.
+// Columns feed the variables of the same name, in the variable's declared
+// type; every computed declaration becomes an output column. Chunks are
+// parsed and evaluated in parallel and written back in input order.
+class DatasetRunner {
+private:
+    Evaluator evaluator;
+    std::vector<CompiledExpression> expressions;
+    std::vector<size_t> expressionSlots;
+    std::vector<size_t> outputSlots;
+    std::vector<std::string> outputNames;
+    std::vector<ValueType> slotTypes;
+    std::vector<Value> defaults;
+    std::vector<size_t> columnSlots;
+    std::vector<std::string> columnNames;
+    ErrorLog errors;
+    std::atomic<unsigned long long> badFields;
+    std::atomic<unsigned long long> rows;
+
+    void bind(const Program& program, const std::vector<std::string>& columns);
+    void prepareBlock(DatasetBlock& block) const;
+    void evaluateBlock(DatasetBlock& block, size_t count, ErrorLog& blockErrors) const;
+    void writeHeader(std::ostream& out) const;
+    void writeBlock(const DatasetBlock& block, size_t count, std::string& out) const;
+    void processCsv(const char* begin, const char* end, std::string& out, ErrorLog& chunkErrors);
+    void processBinary(const double* data, size_t totalRows, size_t first, size_t last,
+                       std::string& out, ErrorLog& chunkErrors);
+
+public:
+    DatasetRunner();
+    void run(const Program& program, const DatasetOptions& options, std::ostream& out);
+    unsigned long long getRows() const;
+    unsigned long long getBadFields() const;
+    const ErrorLog& getErrors() const;
+};
+
+#endif
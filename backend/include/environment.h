@@ -0,0 +1,75 @@
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
+#include "evaluator.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+const size_t ENV_MAX_READERS = 128;
+
+// Immutable version of every variable. Slots are append-only, so an
+// expression compiled against an older slot table stays valid. Variables
+// are double slots (`Value::d`).
+struct VariableSnapshot {
+    std::shared_ptr<const std::map<std::string, size_t>> slots;
+    std::vector<Value> values;
+    uint64_t version;
+};
+
+// Slot-indexed variables shared between one writer side and many readers.
+// Readers pin the current snapshot without taking a lock; writers copy,
+// modify and publish a new snapshot, and retired ones are freed once no
+// reader that could still see them is active (epoch-based reclamation).
+class VariableEnvironment {
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch;
+    };
+
+    // Every pin() loads `current` and `globalEpoch`, so they get a line of
+    // their own instead of sharing one with the writer-only state
+    alignas(64) std::atomic<const VariableSnapshot*> current;
+    std::atomic<uint64_t> globalEpoch;
+    alignas(64) std::mutex writerMutex;
+    std::vector<std::pair<const VariableSnapshot*, uint64_t>> retired;
+    ReaderSlot readers[ENV_MAX_READERS];
+
+    size_t pin();
+    void unpin(size_t reader);
+    void publish(VariableSnapshot* next);
+    void reclaim();
+
+public:
+    class ReadGuard {
+    private:
+        VariableEnvironment* environment;
+        size_t reader;
+        const VariableSnapshot* snapshot;
+
+    public:
+        ReadGuard(VariableEnvironment* environment);
+        ~ReadGuard();
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        const VariableSnapshot& get() const { return *snapshot; }
+        const Value* values() const { return snapshot->values.data(); }
+    };
+
+    VariableEnvironment();
+    ~VariableEnvironment();
+
+    size_t declare(const std::string& name, double value);
+    void set(size_t slot, double value);
+    void set(const std::vector<std::pair<size_t, double>>& updates);
+    ReadGuard read();
+    std::map<std::string, size_t> getSlots();
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef ERRORS_H
+#define ERRORS_H
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+enum EvalStatus {
+    EVAL_OK = 0,
+    EVAL_DIVISION_BY_ZERO,
+    EVAL_MODULO_BY_ZERO,
+    EVAL_UNKNOWN_OPERATOR,
+    EVAL_NOT_ENOUGH_OPERANDS,
+    EVAL_UNKNOWN_TOKEN,
+    EVAL_TOO_MANY_OPERANDS,
+    EVAL_OVERFLOW,
+    EVAL_INVALID_INPUT,
+    EVAL_STATUS_COUNT
+};
+
+const char* evalStatusName(EvalStatus status);
+
+// Failed evaluations return a quiet NaN whose payload carries the status,
+// so the error travels through later arithmetic with no extra branches.
+const uint64_t EVAL_ERROR_TAG = 0x7FF8E70000000000ULL;
+const uint64_t EVAL_ERROR_MASK = 0x7FFFFF0000000000ULL;
+
+inline double evalErrorValue(EvalStatus status) {
+    uint64_t bits = EVAL_ERROR_TAG | static_cast<uint64_t>(status);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline EvalStatus evalErrorStatus(double value) {
+    if (value == value) return EVAL_OK;
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if ((bits & EVAL_ERROR_MASK) != EVAL_ERROR_TAG) return EVAL_OK;
+    uint64_t status = bits & 0xFF;
+    return status < EVAL_STATUS_COUNT ? static_cast<EvalStatus>(status) : EVAL_OK;
+}
+
+// Per-status counters plus a bounded set of diagnostic messages. Callers
+// only format a message when shouldSample() says it will be kept.
+class ErrorLog {
+private:
+    unsigned long long counts[EVAL_STATUS_COUNT];
+    std::vector<std::string> samples[EVAL_STATUS_COUNT];
+    size_t sampleLimit;
+
+public:
+    ErrorLog(size_t sampleLimit = 8);
+    void record(EvalStatus status) { counts[status]++; }
+    bool shouldSample(EvalStatus status) const { return samples[status].size() < sampleLimit; }
+    void addSample(EvalStatus status, const std::string& message);
+    void merge(const ErrorLog& other);
+    void clear();
+
+    unsigned long long getCount(EvalStatus status) const { return counts[status]; }
+    unsigned long long getTotal() const;
+    void write(std::ostream& out) const;
+};
+
+#endif
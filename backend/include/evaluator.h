@@ -1,27 +1,151 @@
 #ifndef EVALUATOR_H
 #define EVALUATOR_H
 
+#include "errors.h"
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <stack>
 #include <map>
 #include <vector>
 
+class Profiler;
+class VariableEnvironment;
+
+enum OpCode {
+    OP_PUSH,
+    OP_LOAD,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_POW,
+    OP_LT,
+    OP_GT,
+    OP_LE,
+    OP_GE,
+    OP_EQ,
+    OP_NE,
+    OP_AND,
+    OP_OR,
+    OP_SELECT,          // c t e -> c ? t : e (batch code only)
+    OP_CAST,            // convert top of stack from `left` to `type`
+    OP_JUMP,            // skip `slot` instructions
+    OP_JUMP_IF_FALSE,   // pop condition, skip `slot` if it is zero
+    OP_AND_JUMP,        // top is zero: replace with 0 and skip `slot`
+    OP_OR_JUMP          // top is non-zero: replace with 1 and skip `slot`
+};
+
+// Declared C types, ordered by conversion rank
+enum ValueType {
+    TYPE_INT,
+    TYPE_FLOAT,
+    TYPE_DOUBLE
+};
+
+ValueType valueTypeOf(const std::string& keyword);
+
+// A value in its declared type. Slots keep every statement's result this
+// way, so int results stay exact int64 between statements.
+union Value {
+    int64_t i;
+    float f;
+    double d;
+};
+
+// C conversion of a double into `type`; values an int64 cannot hold are
+// rejected for int, and NaN as EVAL_INVALID_INPUT
+EvalStatus valueFromDouble(double value, ValueType type, Value& out);
+double valueToDouble(const Value& value, ValueType type);
+// Parses the number at the start of [first, last) into `type`, reading
+// integer text exactly for int. Returns the end of the number, or nullptr
+// if there is none.
+const char* parseValue(const char* first, const char* last, ValueType type,
+                       Value& out, EvalStatus& status);
+
+struct Instruction {
+    OpCode code;
+    ValueType type;     // type produced
+    ValueType left;     // operand types of a binary operator, or the
+    ValueType right;    // then/else branch types of OP_SELECT
+    ValueType test;     // type compared in, or of the condition tested
+    Value value;        // OP_PUSH constant
+    size_t slot;        // OP_LOAD slot, or jump distance
+
+    Instruction(OpCode c, ValueType t) : code(c), type(t), left(t), right(t), test(t), slot(0) {
+        value.d = 0;
+    }
+};
+
+// A postfix expression resolved against a slot table, so it can be run
+// repeatedly without re-reading token strings. Arithmetic follows the usual
+// C conversions: int64 with overflow checks, float32 and double.
+// `code` short-circuits &&, || and ?: with jumps for scalar runs;
+// `batchCode` evaluates every branch and selects per row without branching.
+struct CompiledExpression {
+    std::vector<Instruction> code;
+    std::vector<Instruction> batchCode;
+    size_t maxDepth;
+    ValueType type;         // type of the postfix result
+    ValueType resultType;   // declared type it is converted to
+};
+
+// Rows evaluated per runBatch() call
+const size_t EVAL_BATCH_SIZE = 256;
+
+// One slot over a block of rows: values in the slot's declared type and the
+// first error of each row, or null when no row failed
+struct SlotColumn {
+    const Value* values;
+    const uint8_t* status;
+};
+
 class Evaluator {
 private:
-    std::map<std::string, double> variables;
+    std::unique_ptr<VariableEnvironment> variables;
     std::stack<double> operandStack;
+    Profiler* profiler;
+    EvalStatus lastStatus;
+    ErrorLog errors;
     
     bool isOperator(const std::string& token);
     bool isNumber(const std::string& token);
-    double applyOperator(const std::string& op, double a, double b);
+    double applyOperator(const std::string& op, double a, double b) const;
     double evaluatePostfix(const std::vector<std::string>& postfix);
 
 public:
     Evaluator();
+    ~Evaluator();
+    // Variables live in a VariableEnvironment: each evaluate() reads one
+    // snapshot without locking, and setVariable() publishes a new one
     void setVariable(const std::string& name, double value);
+    // Errors come back as a NaN-boxed status (see errors.h) instead of being
+    // printed; they are also counted in getErrors()
     double evaluate(const std::vector<std::string>& postfix);
-    std::map<std::string, double> getVariables();
+    EvalStatus getLastStatus() const;
+    const ErrorLog& getErrors() const;
+    std::map<std::string, double> getVariables() const;
+    VariableEnvironment& getEnvironment();
     void clearVariables();
+    void setProfiler(Profiler* profiler);
+
+    // Slots without an entry in slotTypes are double
+    CompiledExpression compile(const std::vector<std::string>& postfix,
+                               const std::map<std::string, size_t>& slots,
+                               ValueType resultType = TYPE_DOUBLE,
+                               const std::vector<ValueType>& slotTypes = std::vector<ValueType>());
+    // Reads no evaluator state, so one instance can be shared by reader threads.
+    // `slots` hold values in their declared types and `slotStatus` the error
+    // each slot ended with (null when none failed). Returns EVAL_OK and the
+    // value in the declared result type, or the first error.
+    EvalStatus run(const CompiledExpression& expression, const Value* slots,
+                   const uint8_t* slotStatus, Value& result) const;
+    // Column-at-a-time form of run() for up to EVAL_BATCH_SIZE rows. `out` and
+    // `status` receive `count` results and row errors (EVAL_OK for good rows).
+    // Float formulas run on float32 lanes.
+    void runBatch(const CompiledExpression& expression, const SlotColumn* columns,
+                  size_t count, Value* out, uint8_t* status) const;
 };
 
 #endif 
\ No newline at end of file
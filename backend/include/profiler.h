@@ -0,0 +1,50 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct TokenProfile {
+    std::string token;
+    int parent;
+    unsigned long long calls;
+    unsigned long long nanoseconds;
+};
+
+struct StatementProfile {
+    std::string label;
+    std::vector<TokenProfile> tokens;
+    unsigned long long runs;
+    unsigned long long nanoseconds;
+    size_t maxDepth;
+    std::map<std::string, unsigned long long> errors;
+};
+
+// Collects per-token counts, time, stack depth and error hits while
+// Evaluator::evaluate runs, for an "explain analyze" style report.
+class Profiler {
+private:
+    std::vector<StatementProfile> statements;
+    std::string label;
+    StatementProfile* active;
+    std::chrono::steady_clock::time_point runStart;
+
+    int operandCount(const std::string& token);
+    StatementProfile& findStatement(const std::vector<std::string>& postfix);
+
+public:
+    Profiler();
+    void beginStatement(const std::string& label);
+    void beginRun(const std::vector<std::string>& postfix);
+    void endRun();
+    void recordToken(size_t position, unsigned long long nanoseconds, size_t depth);
+    void recordError(const std::string& kind);
+
+    void writeAnnotated(std::ostream& out) const;
+    void writeFolded(std::ostream& out) const;
+};
+
+#endif
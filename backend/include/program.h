@@ -0,0 +1,35 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "lexer.h"
+#include "evaluator.h"
+#include <string>
+#include <vector>
+#include <map>
+
+// One numeric declaration such as `int sum = a + b;`
+struct Statement {
+    std::string type;
+    std::string name;
+    std::vector<std::string> postfix;
+
+    bool isLiteral() const;
+};
+
+class Program {
+private:
+    std::vector<Statement> statements;
+    std::map<std::string, size_t> slots;
+
+    bool isNumericType(const std::string& type);
+    void addStatement(const std::vector<Token>& tokens);
+
+public:
+    Program(const std::string& source);
+    const std::vector<Statement>& getStatements() const;
+    const std::map<std::string, size_t>& getSlots() const;
+    std::vector<size_t> getInputs() const;
+    std::vector<ValueType> getSlotTypes() const;
+};
+
+#endif
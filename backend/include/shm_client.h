@@ -0,0 +1,29 @@
+#ifndef SHM_CLIENT_H
+#define SHM_CLIENT_H
+
+#include "shm_ring.h"
+#include <string>
+
+// Client library for a daemon started with `--daemon <name>`. The rings have
+// a single producer, so a second client on the same channel is rejected.
+class ShmClient {
+private:
+    ShmRegion* region;
+    uint64_t nextSequence;
+
+    void exchange(uint32_t expressionId, const double* values, uint32_t count, ShmResponse& response);
+    void backoff(unsigned& spins) const;
+
+public:
+    ShmClient(const std::string& name);
+    ~ShmClient();
+    ShmClient(const ShmClient&) = delete;
+    ShmClient& operator=(const ShmClient&) = delete;
+    int evaluate(uint32_t expressionId, const double* values, uint32_t count, double& result);
+    // Exact result of an int statement; SHM_NOT_INT for float and double ones
+    int evaluate(uint32_t expressionId, const double* values, uint32_t count, int64_t& result);
+    uint32_t getExpressionCount() const;
+    uint32_t getInputCount() const;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <signal.h>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+const uint32_t SHM_MAGIC = 0x41455632; // "AEV2"
+const size_t SHM_MAX_VALUES = 16;
+const size_t SHM_RING_CAPACITY = 1024;
+const size_t SHM_CACHE_LINE = 64;
+
+enum ShmStatus {
+    SHM_OK = 0,
+    SHM_BAD_EXPRESSION = 1,
+    SHM_TOO_MANY_VALUES = 2,
+    SHM_EVAL_ERROR = 3,     // result holds the NaN-boxed EvalStatus
+    SHM_NOT_INT = 4         // an exact int result was asked of a float/double statement
+};
+
+// Client -> daemon: evaluate statement `expressionId` with the program
+// inputs (literal declarations, in declaration order) replaced by `values`.
+struct ShmRequest {
+    uint64_t sequence;
+    uint32_t expressionId;
+    uint32_t count;
+    double values[SHM_MAX_VALUES];
+};
+
+// Daemon -> client. Int statements also carry their exact value in
+// `intResult`, since a double only holds integers up to 2^53.
+struct ShmResponse {
+    uint64_t sequence;
+    int32_t status;
+    uint32_t isInt;
+    double result;
+    int64_t intResult;
+};
+
+// Single-producer/single-consumer ring. Head and tail live on separate
+// cache lines so the two sides never write to the same line.
+template <typename T, size_t N>
+struct SpscRing {
+    static_assert((N & (N - 1)) == 0, "ring capacity must be a power of two");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "shared-memory ring needs lock-free 64-bit atomics");
+
+    alignas(SHM_CACHE_LINE) std::atomic<uint64_t> head;
+    alignas(SHM_CACHE_LINE) std::atomic<uint64_t> tail;
+    alignas(SHM_CACHE_LINE) T slots[N];
+
+    void reset() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    bool tryPush(const T& item) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == N) return false;
+        slots[t & (N - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = slots[h & (N - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// `daemonPid` lets a new daemon tell a stale segment from a live one;
+// `clientPid` is the one client allowed to push requests (0 when free).
+struct ShmRegion {
+    uint32_t magic;
+    uint32_t expressionCount;
+    uint32_t inputCount;
+    std::atomic<uint32_t> ready;
+    std::atomic<int32_t> daemonPid;
+    std::atomic<int32_t> clientPid;
+    SpscRing<ShmRequest, SHM_RING_CAPACITY> requests;
+    SpscRing<ShmResponse, SHM_RING_CAPACITY> responses;
+};
+
+inline void shmCpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// Busy-wait budget before yielding. Spinning only pays off when the other
+// side of the ring runs on a different core.
+inline unsigned shmSpinLimit() {
+    static const unsigned limit = std::thread::hardware_concurrency() > 1 ? 4096 : 0;
+    return limit;
+}
+
+// True if `pid` names a process that has exited
+inline bool shmProcessGone(int32_t pid) {
+    return pid <= 0 || (kill(pid, 0) != 0 && errno == ESRCH);
+}
+
+#endif
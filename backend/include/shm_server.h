@@ -0,0 +1,37 @@
+#ifndef SHM_SERVER_H
+#define SHM_SERVER_H
+
+#include "program.h"
+#include "evaluator.h"
+#include "shm_ring.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Daemon side of the shared-memory channel. Owns the segment, compiles the
+// program once and answers requests from a single client.
+class ShmServer {
+private:
+    std::string name;
+    ShmRegion* region;
+    Evaluator evaluator;
+    std::vector<CompiledExpression> expressions;
+    std::vector<int> inputOrdinal;
+    std::vector<ValueType> types;
+    std::vector<Value> defaults;
+    std::vector<Value> slots;
+    std::vector<uint8_t> slotStatus;
+    std::atomic<bool> running;
+    ErrorLog errors;
+
+    void handle(const ShmRequest& request, ShmResponse& response);
+
+public:
+    ShmServer(const std::string& name, const Program& program);
+    ~ShmServer();
+    void serve();
+    void stop();
+    const ErrorLog& getErrors() const;
+};
+
+#endif
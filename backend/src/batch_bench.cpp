@@ -0,0 +1,72 @@
+#include "../include/program.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Throughput of Evaluator::runBatch against row-at-a-time run() for the
+// same formula declared as double, float and int, and for a conditional.
+// Usage: batch_bench [rows]
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::atol(argv[1]) : 10000000;
+    const char* types[] = {"double", "float", "int"};
+    const char* formulas[] = {
+        "a * b + c * a - b * c + a * a - (a + b) * (b - c)",
+        "a * b + c * a - b * c + a * a - (a + b) * (b - c)",
+        "a * b + c * a - b * c + a * a - (a + b) * (b - c)",
+        "a > b ? a * c : (b < c ? b - c : c)"
+    };
+    const char* labels[] = {"double", "float", "int", "double ?:"};
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> distribution(1, 100);
+    std::vector<std::vector<double>> data(3, std::vector<double>(rows));
+    for (auto& column : data) {
+        for (auto& value : column) value = distribution(generator);
+    }
+    std::vector<std::vector<Value>> typed(3, std::vector<Value>(rows));
+
+    for (int f = 0; f < 4; ++f) {
+        std::string t(types[f % 3]);
+        for (size_t column = 0; column < 3; ++column) {
+            for (size_t row = 0; row < rows; ++row) {
+                valueFromDouble(data[column][row], valueTypeOf(t), typed[column][row]);
+            }
+        }
+        Program program(t + " a = 0; " + t + " b = 0; " + t + " c = 0; " +
+                        t + " r = " + formulas[f] + ";");
+        Evaluator evaluator;
+        CompiledExpression expression = evaluator.compile(program.getStatements()[3].postfix,
+                                                          program.getSlots(), valueTypeOf(t),
+                                                          program.getSlotTypes());
+
+        std::vector<Value> out(EVAL_BATCH_SIZE);
+        std::vector<uint8_t> status(EVAL_BATCH_SIZE);
+        double sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t first = 0; first < rows; first += EVAL_BATCH_SIZE) {
+            size_t count = std::min(EVAL_BATCH_SIZE, rows - first);
+            SlotColumn columns[] = {{typed[0].data() + first, nullptr}, {typed[1].data() + first, nullptr},
+                                    {typed[2].data() + first, nullptr}, {nullptr, nullptr}};
+            evaluator.runBatch(expression, columns, count, out.data(), status.data());
+            sink += out[0].d;
+        }
+        std::chrono::duration<double> batch = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        for (size_t row = 0; row < rows; ++row) {
+            Value slots[] = {typed[0][row], typed[1][row], typed[2][row], Value()};
+            Value result;
+            evaluator.run(expression, slots, nullptr, result);
+            sink += result.d;
+        }
+        std::chrono::duration<double> scalar = std::chrono::steady_clock::now() - start;
+
+        std::cout << labels[f] << ": batch " << static_cast<unsigned long long>(rows / batch.count())
+                  << " rows/s, scalar " << static_cast<unsigned long long>(rows / scalar.count())
+                  << " rows/s" << (sink == -1 ? " " : "") << "\n";
+    }
+
+    return 0;
+}
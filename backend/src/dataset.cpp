@@ -0,0 +1,426 @@
+#include "../include/dataset.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Read-only mapping of the whole input file
+class MappedFile {
+private:
+    void* data;
+    size_t size;
+
+public:
+    MappedFile(const std::string& path) : data(nullptr), size(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open dataset " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error("Cannot stat dataset " + path);
+        }
+        size = static_cast<size_t>(info.st_size);
+        if (size > 0) {
+            data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Cannot map dataset " + path);
+            }
+            madvise(data, size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) munmap(data, size);
+    }
+
+    const char* begin() const { return static_cast<const char*>(data); }
+    size_t length() const { return size; }
+};
+
+const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p;
+}
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// Row `row` of a slot as output text; rows with an error read "nan"
+void appendValue(std::string& out, const SlotColumn& column, ValueType type, size_t row) {
+    if (column.status && column.status[row] != EVAL_OK) {
+        out += "nan";
+        return;
+    }
+    char buffer[32];
+    std::to_chars_result written;
+    switch (type) {
+        case TYPE_INT: written = std::to_chars(buffer, buffer + sizeof(buffer), column.values[row].i); break;
+        case TYPE_FLOAT: written = std::to_chars(buffer, buffer + sizeof(buffer), column.values[row].f); break;
+        default: written = std::to_chars(buffer, buffer + sizeof(buffer), column.values[row].d); break;
+    }
+    out.append(buffer, written.ptr);
+}
+
+}
+
+DatasetRunner::DatasetRunner() : badFields(0), rows(0) {}
+
+void DatasetRunner::bind(const Program& program, const std::vector<std::string>& columns) {
+    const std::vector<Statement>& statements = program.getStatements();
+    std::map<std::string, size_t> slots = program.getSlots();
+    std::vector<bool> fromColumn(statements.size(), false);
+
+    expressions.clear();
+    expressionSlots.clear();
+    outputSlots.clear();
+    outputNames.clear();
+
+    // Columns replace declarations of the same name; others get new slots
+    columnNames = columns;
+    columnSlots.clear();
+    for (const auto& column : columns) {
+        auto it = slots.find(column);
+        if (it == slots.end()) {
+            size_t slot = slots.size();
+            slots[column] = slot;
+            columnSlots.push_back(slot);
+        } else {
+            fromColumn[it->second] = true;
+            columnSlots.push_back(it->second);
+        }
+    }
+
+    std::map<std::string, size_t> visible;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        visible[columns[i]] = columnSlots[i];
+    }
+
+    // Columns that are not declared in the program are read as double
+    slotTypes = program.getSlotTypes();
+    slotTypes.resize(slots.size(), TYPE_DOUBLE);
+
+    defaults.assign(slots.size(), Value());
+    for (size_t i = 0; i < statements.size(); ++i) {
+        const Statement& statement = statements[i];
+        if (!fromColumn[i]) {
+            CompiledExpression compiled = evaluator.compile(statement.postfix, visible,
+                                                            valueTypeOf(statement.type), slotTypes);
+            if (statement.isLiteral()) {
+                evaluator.run(compiled, nullptr, nullptr, defaults[i]);
+            } else {
+                expressions.push_back(compiled);
+                expressionSlots.push_back(i);
+                outputSlots.push_back(i);
+                outputNames.push_back(statement.name);
+            }
+        }
+        visible[statement.name] = i;
+    }
+
+    if (outputSlots.empty()) {
+        throw std::runtime_error("Program has no computed declarations to output");
+    }
+}
+
+void DatasetRunner::prepareBlock(DatasetBlock& block) const {
+    block.values.assign(defaults.size(), std::vector<Value>(EVAL_BATCH_SIZE));
+    block.status.assign(defaults.size(), std::vector<uint8_t>(EVAL_BATCH_SIZE, EVAL_OK));
+    block.columns.resize(defaults.size());
+    for (size_t slot = 0; slot < defaults.size(); ++slot) {
+        std::fill(block.values[slot].begin(), block.values[slot].end(), defaults[slot]);
+        block.columns[slot].values = block.values[slot].data();
+        block.columns[slot].status = block.status[slot].data();
+    }
+}
+
+void DatasetRunner::evaluateBlock(DatasetBlock& block, size_t count, ErrorLog& blockErrors) const {
+    bool failed[EVAL_BATCH_SIZE] = {};
+
+    for (size_t i = 0; i < expressions.size(); ++i) {
+        size_t slot = expressionSlots[i];
+        uint8_t* status = block.status[slot].data();
+        evaluator.runBatch(expressions[i], block.columns.data(), count, block.values[slot].data(), status);
+
+        // Errors propagate into later statements, so count each row once.
+        // Invalid input is already counted as a bad field.
+        for (size_t row = 0; row < count; ++row) {
+            if (status[row] == EVAL_OK || failed[row]) continue;
+            EvalStatus error = static_cast<EvalStatus>(status[row]);
+
+            failed[row] = true;
+            if (error == EVAL_INVALID_INPUT) continue;
+            blockErrors.record(error);
+            if (blockErrors.shouldSample(error)) {
+                std::string message = std::string(evalStatusName(error)) + " computing " + outputNames[i] + " at";
+                for (size_t column = 0; column < columnNames.size(); ++column) {
+                    size_t columnSlot = columnSlots[column];
+                    message += " " + columnNames[column] + "=";
+                    appendValue(message, block.columns[columnSlot], slotTypes[columnSlot], row);
+                }
+                blockErrors.addSample(error, message);
+            }
+        }
+    }
+}
+
+void DatasetRunner::writeHeader(std::ostream& out) const {
+    for (size_t i = 0; i < outputNames.size(); ++i) {
+        if (i > 0) out << ",";
+        out << outputNames[i];
+    }
+    out << "\n";
+}
+
+void DatasetRunner::writeBlock(const DatasetBlock& block, size_t count, std::string& out) const {
+    for (size_t row = 0; row < count; ++row) {
+        for (size_t i = 0; i < outputSlots.size(); ++i) {
+            if (i > 0) out += ',';
+            appendValue(out, block.columns[outputSlots[i]], slotTypes[outputSlots[i]], row);
+        }
+        out += '\n';
+    }
+}
+
+void DatasetRunner::processCsv(const char* begin, const char* end, std::string& out,
+                               ErrorLog& chunkErrors) {
+    DatasetBlock block;
+    prepareBlock(block);
+
+    unsigned long long bad = 0;
+    unsigned long long count = 0;
+    size_t row = 0;
+    const char* p = begin;
+
+    // Parse up to EVAL_BATCH_SIZE rows into column buffers, then evaluate
+    // and format the whole block
+    while (p < end) {
+        const char* lineEnd = p;
+        while (lineEnd < end && *lineEnd != '\n') ++lineEnd;
+        const char* fieldEnd = lineEnd > p && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+
+        if (fieldEnd > p) {
+            const char* field = p;
+            for (size_t column = 0; column < columnSlots.size(); ++column) {
+                size_t slot = columnSlots[column];
+                Value& value = block.values[slot][row];
+                EvalStatus status;
+                field = skipSpaces(field, fieldEnd);
+                const char* parsed = parseValue(field, fieldEnd, slotTypes[slot], value, status);
+                if (!parsed) {
+                    value.d = std::numeric_limits<double>::quiet_NaN();
+                    status = EVAL_INVALID_INPUT;
+                    parsed = field;
+                    bad++;
+                }
+                block.status[slot][row] = static_cast<uint8_t>(status);
+
+                field = parsed;
+                while (field < fieldEnd && *field != ',') ++field;
+                if (field < fieldEnd) ++field;
+            }
+            row++;
+        }
+
+        p = lineEnd + 1;
+        if (row == EVAL_BATCH_SIZE || (p >= end && row > 0)) {
+            evaluateBlock(block, row, chunkErrors);
+            writeBlock(block, row, out);
+            count += row;
+            row = 0;
+        }
+    }
+
+    badFields += bad;
+    rows += count;
+}
+
+void DatasetRunner::processBinary(const double* data, size_t totalRows, size_t first, size_t last,
+                                  std::string& out, ErrorLog& chunkErrors) {
+    DatasetBlock block;
+    prepareBlock(block);
+    unsigned long long bad = 0;
+
+    // Input columns are already column-major, so double columns are read in
+    // place; int and float columns are converted a block at a time
+    for (size_t start = first; start < last; start += EVAL_BATCH_SIZE) {
+        size_t count = std::min(EVAL_BATCH_SIZE, last - start);
+        for (size_t column = 0; column < columnSlots.size(); ++column) {
+            size_t slot = columnSlots[column];
+            const double* source = data + column * totalRows + start;
+            if (slotTypes[slot] == TYPE_DOUBLE) {
+                block.columns[slot].values = reinterpret_cast<const Value*>(source);
+                block.columns[slot].status = nullptr;
+                continue;
+            }
+            for (size_t row = 0; row < count; ++row) {
+                EvalStatus status = valueFromDouble(source[row], slotTypes[slot], block.values[slot][row]);
+                block.status[slot][row] = static_cast<uint8_t>(status);
+                bad += status == EVAL_INVALID_INPUT;
+            }
+        }
+        evaluateBlock(block, count, chunkErrors);
+        writeBlock(block, count, out);
+    }
+    badFields += bad;
+    rows += last - first;
+}
+
+void DatasetRunner::run(const Program& program, const DatasetOptions& options, std::ostream& out) {
+    MappedFile file(options.path);
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    // Chunk boundaries: byte ranges for CSV, row ranges for binary files
+    std::vector<std::pair<size_t, size_t>> chunks;
+    const char* text = file.begin();
+    size_t totalRows = 0;
+
+    if (options.binary) {
+        if (options.columns.empty()) {
+            throw std::runtime_error("--binary needs a column list");
+        }
+        size_t rowBytes = options.columns.size() * sizeof(double);
+        if (file.length() % rowBytes != 0) {
+            throw std::runtime_error("Binary dataset size is not a multiple of the column count");
+        }
+        bind(program, options.columns);
+
+        totalRows = file.length() / rowBytes;
+        size_t chunkRows = std::max<size_t>(1, options.chunkBytes / rowBytes);
+        for (size_t first = 0; first < totalRows; first += chunkRows) {
+            chunks.push_back(std::make_pair(first, std::min(totalRows, first + chunkRows)));
+        }
+    } else {
+        size_t headerEnd = 0;
+        while (headerEnd < file.length() && text[headerEnd] != '\n') ++headerEnd;
+
+        std::vector<std::string> columns;
+        std::string header(text ? text : "", headerEnd);
+        size_t start = 0;
+        while (start <= header.size()) {
+            size_t comma = header.find(',', start);
+            if (comma == std::string::npos) comma = header.size();
+            columns.push_back(trim(header.substr(start, comma - start)));
+            start = comma + 1;
+        }
+        bind(program, columns);
+
+        size_t position = std::min(file.length(), headerEnd + 1);
+        while (position < file.length()) {
+            size_t next = std::min(file.length(), position + options.chunkBytes);
+            while (next < file.length() && text[next - 1] != '\n') ++next;
+            chunks.push_back(std::make_pair(position, next));
+            position = next;
+        }
+    }
+
+    writeHeader(out);
+
+    // A fixed pool of workers takes chunks in order while this thread writes
+    // finished ones, so output of chunk k overlaps work on the next ones.
+    // Workers stay at most `window` chunks ahead of the writer, which bounds
+    // the buffered output.
+    struct ChunkResult {
+        std::string output;
+        ErrorLog errors;
+        bool done;
+
+        ChunkResult() : done(false) {}
+    };
+
+    size_t window = 2 * static_cast<size_t>(threads);
+    std::vector<ChunkResult> results(window);
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::condition_variable freed;
+    size_t next = 0;
+    size_t written = 0;
+
+    auto work = [&]() {
+        for (;;) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                freed.wait(lock, [&]() { return next >= chunks.size() || next < written + window; });
+                if (next >= chunks.size()) return;
+                index = next++;
+            }
+
+            ChunkResult& result = results[index % window];
+            const auto& chunk = chunks[index];
+            result.output.clear();
+            result.errors.clear();
+            if (options.binary) {
+                processBinary(reinterpret_cast<const double*>(text), totalRows,
+                              chunk.first, chunk.second, result.output, result.errors);
+            } else {
+                processCsv(text + chunk.first, text + chunk.second, result.output, result.errors);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                result.done = true;
+            }
+            finished.notify_all();
+        }
+    };
+
+    errors.clear();
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < std::min<size_t>(threads, chunks.size()); ++i) {
+        workers.emplace_back(work);
+    }
+
+    for (size_t index = 0; index < chunks.size(); ++index) {
+        ChunkResult& result = results[index % window];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&]() { return result.done; });
+        }
+
+        out.write(result.output.data(), result.output.size());
+        errors.merge(result.errors);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            result.done = false;
+            written = index + 1;
+        }
+        freed.notify_all();
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    out.flush();
+}
+
+unsigned long long DatasetRunner::getRows() const {
+    return rows;
+}
+
+unsigned long long DatasetRunner::getBadFields() const {
+    return badFields;
+}
+
+const ErrorLog& DatasetRunner::getErrors() const {
+    return errors;
+}
@@ -0,0 +1,136 @@
+#include "../include/environment.h"
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+VariableEnvironment::VariableEnvironment() : globalEpoch(1) {
+    for (auto& reader : readers) {
+        reader.epoch.store(0);
+    }
+
+    VariableSnapshot* initial = new VariableSnapshot;
+    initial->slots = std::make_shared<const std::map<std::string, size_t>>();
+    initial->version = 0;
+    current.store(initial);
+}
+
+VariableEnvironment::~VariableEnvironment() {
+    delete current.load();
+    for (const auto& entry : retired) {
+        delete entry.first;
+    }
+}
+
+size_t VariableEnvironment::pin() {
+    // Each thread starts probing at its own slot so readers do not share
+    // cache lines in the steady state
+    static std::atomic<size_t> nextHint(0);
+    thread_local size_t hint = nextHint.fetch_add(1) % ENV_MAX_READERS;
+
+    while (true) {
+        for (size_t i = 0; i < ENV_MAX_READERS; ++i) {
+            size_t reader = (hint + i) % ENV_MAX_READERS;
+            uint64_t idle = 0;
+            if (readers[reader].epoch.compare_exchange_strong(idle, globalEpoch.load())) {
+                return reader;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+void VariableEnvironment::unpin(size_t reader) {
+    readers[reader].epoch.store(0, std::memory_order_release);
+}
+
+VariableEnvironment::ReadGuard::ReadGuard(VariableEnvironment* environment)
+    : environment(environment), reader(environment->pin()),
+      snapshot(environment->current.load()) {}
+
+VariableEnvironment::ReadGuard::~ReadGuard() {
+    environment->unpin(reader);
+}
+
+VariableEnvironment::ReadGuard VariableEnvironment::read() {
+    return ReadGuard(this);
+}
+
+void VariableEnvironment::publish(VariableSnapshot* next) {
+    // Caller holds writerMutex. A reader that announced an epoch older than
+    // `retiredAt` may still hold the previous snapshot; later readers are
+    // guaranteed to load `next`.
+    const VariableSnapshot* previous = current.exchange(next);
+    uint64_t retiredAt = globalEpoch.fetch_add(1) + 1;
+    retired.push_back(std::make_pair(previous, retiredAt));
+    reclaim();
+}
+
+void VariableEnvironment::reclaim() {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (const auto& reader : readers) {
+        uint64_t epoch = reader.epoch.load();
+        if (epoch != 0 && epoch < oldest) oldest = epoch;
+    }
+
+    size_t kept = 0;
+    for (const auto& entry : retired) {
+        if (entry.second <= oldest) {
+            delete entry.first;
+        } else {
+            retired[kept++] = entry;
+        }
+    }
+    retired.resize(kept);
+}
+
+size_t VariableEnvironment::declare(const std::string& name, double value) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const VariableSnapshot* previous = current.load();
+
+    auto existing = previous->slots->find(name);
+    if (existing != previous->slots->end()) {
+        VariableSnapshot* next = new VariableSnapshot(*previous);
+        next->values[existing->second].d = value;
+        next->version++;
+        publish(next);
+        return existing->second;
+    }
+
+    auto slots = std::make_shared<std::map<std::string, size_t>>(*previous->slots);
+    size_t slot = previous->values.size();
+    (*slots)[name] = slot;
+
+    VariableSnapshot* next = new VariableSnapshot;
+    next->slots = slots;
+    next->values = previous->values;
+    next->values.push_back(Value());
+    next->values.back().d = value;
+    next->version = previous->version + 1;
+    publish(next);
+    return slot;
+}
+
+void VariableEnvironment::set(size_t slot, double value) {
+    set(std::vector<std::pair<size_t, double>>(1, std::make_pair(slot, value)));
+}
+
+void VariableEnvironment::set(const std::vector<std::pair<size_t, double>>& updates) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const VariableSnapshot* previous = current.load();
+
+    VariableSnapshot* next = new VariableSnapshot(*previous);
+    for (const auto& update : updates) {
+        if (update.first >= next->values.size()) {
+            delete next;
+            throw std::out_of_range("Unknown variable slot " + std::to_string(update.first));
+        }
+        next->values[update.first].d = update.second;
+    }
+    next->version++;
+    publish(next);
+}
+
+std::map<std::string, size_t> VariableEnvironment::getSlots() {
+    ReadGuard guard(this);
+    return *guard.get().slots;
+}
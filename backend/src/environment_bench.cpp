@@ -0,0 +1,68 @@
+#include "../include/environment.h"
+#include "../include/evaluator.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Reader throughput against a VariableEnvironment while a writer keeps
+// publishing new input values.
+// Usage: environment_bench [max-readers] [milliseconds]
+int main(int argc, char* argv[]) {
+    unsigned maxReaders = argc > 1 ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    int milliseconds = argc > 2 ? std::atoi(argv[2]) : 500;
+    if (maxReaders == 0) maxReaders = 1;
+
+    VariableEnvironment environment;
+    size_t a = environment.declare("a", 5);
+    environment.declare("b", 10);
+    environment.declare("c", 2.5);
+
+    Evaluator evaluator;
+    CompiledExpression expression = evaluator.compile({"a", "b", "*", "c", "+", "a", "/"},
+                                                      environment.getSlots());
+
+    for (unsigned readers = 1; readers <= maxReaders; readers *= 2) {
+        std::atomic<bool> running(true);
+        std::atomic<unsigned long long> evaluations(0);
+        std::atomic<unsigned long long> publishes(0);
+
+        std::thread writer([&]() {
+            double value = 1;
+            while (running.load(std::memory_order_relaxed)) {
+                environment.set(a, value++);
+                publishes.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < readers; ++i) {
+            threads.emplace_back([&]() {
+                unsigned long long count = 0;
+                double sink = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    VariableEnvironment::ReadGuard guard = environment.read();
+                    Value result;
+                    evaluator.run(expression, guard.values(), nullptr, result);
+                    sink += result.d;
+                    count++;
+                }
+                evaluations.fetch_add(count + (sink == -1 ? 1 : 0));
+            });
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+        running.store(false);
+        for (auto& thread : threads) thread.join();
+        writer.join();
+
+        double seconds = milliseconds / 1000.0;
+        std::cout << readers << " readers: " << static_cast<unsigned long long>(evaluations / seconds)
+                  << " evaluations/s, " << static_cast<unsigned long long>(publishes / seconds)
+                  << " updates/s\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "../include/errors.h"
+
+const char* evalStatusName(EvalStatus status) {
+    switch (status) {
+        case EVAL_OK: return "ok";
+        case EVAL_DIVISION_BY_ZERO: return "division by zero";
+        case EVAL_MODULO_BY_ZERO: return "modulo by zero";
+        case EVAL_UNKNOWN_OPERATOR: return "unknown operator";
+        case EVAL_NOT_ENOUGH_OPERANDS: return "not enough operands";
+        case EVAL_UNKNOWN_TOKEN: return "unknown token";
+        case EVAL_TOO_MANY_OPERANDS: return "too many operands";
+        case EVAL_OVERFLOW: return "integer overflow";
+        case EVAL_INVALID_INPUT: return "invalid input";
+        default: return "unknown error";
+    }
+}
+
+ErrorLog::ErrorLog(size_t sampleLimit) : sampleLimit(sampleLimit) {
+    clear();
+}
+
+void ErrorLog::addSample(EvalStatus status, const std::string& message) {
+    if (shouldSample(status)) {
+        samples[status].push_back(message);
+    }
+}
+
+void ErrorLog::merge(const ErrorLog& other) {
+    for (int i = 0; i < EVAL_STATUS_COUNT; ++i) {
+        counts[i] += other.counts[i];
+        for (const auto& sample : other.samples[i]) {
+            addSample(static_cast<EvalStatus>(i), sample);
+        }
+    }
+}
+
+void ErrorLog::clear() {
+    for (int i = 0; i < EVAL_STATUS_COUNT; ++i) {
+        counts[i] = 0;
+        samples[i].clear();
+    }
+}
+
+unsigned long long ErrorLog::getTotal() const {
+    unsigned long long total = 0;
+    for (int i = EVAL_OK + 1; i < EVAL_STATUS_COUNT; ++i) {
+        total += counts[i];
+    }
+    return total;
+}
+
+void ErrorLog::write(std::ostream& out) const {
+    for (int i = EVAL_OK + 1; i < EVAL_STATUS_COUNT; ++i) {
+        if (counts[i] > 0) {
+            out << "Error: " << evalStatusName(static_cast<EvalStatus>(i))
+                << " x" << counts[i] << "\n";
+        }
+        for (const auto& sample : samples[i]) {
+            out << "  " << sample << "\n";
+        }
+    }
+}
@@ -0,0 +1,151 @@
+#include "../include/program.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Runs the same programs and inputs through the string interpreter
+// (Evaluator::evaluate), Evaluator::run and Evaluator::runBatch and reports
+// every row where they disagree on a value or an error. The interpreter
+// works in double, so it only takes part for all-double programs.
+// Usage: eval_check [rows]; exits with 1 on any mismatch.
+
+namespace {
+
+struct CheckCase {
+    const char* source;     // input declarations first, then the checked ones
+    size_t inputs;
+    bool interpreted;
+};
+
+const CheckCase cases[] = {
+    {"double a = 0; double b = 0; double c = 0;"
+     "double p = a * b + c / (a - b);"
+     "double q = a % b + b ^ 2;"
+     "double r = a > b ? a / c : b - c;"
+     "double s = b != 0 && a / b > 1 || c < 0;"
+     "double t = (a < b) + (a <= b) * 2 + (a == c) * 4 + (b >= c) * 8;"
+     "double u = p + q * r;", 3, true},
+    {"int a = 0; int b = 0; int c = 0;"
+     "int p = a * b + c / (a - b);"
+     "int q = a % b + b ^ 2;"
+     "int r = 9223372036854775807 + a;"
+     "int s = b != 0 ? a % b : a / b;"
+     "int t = a * 3037000500 * 3037000500;"
+     "int u = p - q;", 3, false},
+    {"double x = 0; double limit = 0; int a = 0; int b = 0; float f = 0;"
+     "double p = x > limit ? a : b;"
+     "int q = b != 0 && a / b > 1 || x < 0;"
+     "float u = f >= 1.5 ? f * 2 : f - x;"
+     "int v = (a < b) + (a == b) * 4 + (x != limit) * 8 + (f > 0 || b / 0);"
+     "float g = f * a / 3;"
+     "double w = q ? p : u;", 5, false},
+};
+
+bool sameValue(const Value& a, const Value& b, ValueType type) {
+    switch (type) {
+        case TYPE_INT: return a.i == b.i;
+        case TYPE_FLOAT: return a.f == b.f || (a.f != a.f && b.f != b.f);
+        case TYPE_DOUBLE: return a.d == b.d || (a.d != a.d && b.d != b.d);
+    }
+    return false;
+}
+
+std::string describe(const Value& value, uint8_t status, ValueType type) {
+    if (status != EVAL_OK) return evalStatusName(static_cast<EvalStatus>(status));
+    return type == TYPE_INT ? std::to_string(value.i) : std::to_string(valueToDouble(value, type));
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::atol(argv[1]) : 4000;
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> small(-3, 3);
+    unsigned long long mismatches = 0;
+
+    for (size_t index = 0; index < sizeof(cases) / sizeof(cases[0]); ++index) {
+        const CheckCase& check = cases[index];
+        Program program(check.source);
+        const std::vector<Statement>& statements = program.getStatements();
+        std::vector<ValueType> types = program.getSlotTypes();
+        size_t slotCount = statements.size();
+
+        Evaluator evaluator;
+        std::vector<CompiledExpression> expressions;
+        std::map<std::string, size_t> visible;
+        for (size_t i = 0; i < slotCount; ++i) {
+            expressions.push_back(evaluator.compile(statements[i].postfix, visible, types[i], types));
+            visible[statements[i].name] = i;
+        }
+
+        // Small integers and quarter steps hit zero divisors, ties and both branches
+        std::vector<std::vector<Value>> values(slotCount, std::vector<Value>(rows));
+        std::vector<std::vector<uint8_t>> status(slotCount, std::vector<uint8_t>(rows, EVAL_OK));
+        for (size_t row = 0; row < rows; ++row) {
+            for (size_t i = 0; i < check.inputs; ++i) {
+                double input = small(generator) * (types[i] == TYPE_INT || row % 2 ? 1 : 0.75);
+                valueFromDouble(input, types[i], values[i][row]);
+            }
+        }
+
+        for (size_t first = 0; first < rows; first += EVAL_BATCH_SIZE) {
+            size_t count = std::min(EVAL_BATCH_SIZE, rows - first);
+            std::vector<SlotColumn> columns(slotCount);
+            for (size_t i = 0; i < slotCount; ++i) {
+                columns[i].values = values[i].data() + first;
+                columns[i].status = status[i].data() + first;
+            }
+            for (size_t i = check.inputs; i < slotCount; ++i) {
+                evaluator.runBatch(expressions[i], columns.data(), count,
+                                   values[i].data() + first, status[i].data() + first);
+            }
+        }
+
+        Evaluator interpreter;
+        std::vector<Value> slots(slotCount);
+        std::vector<uint8_t> slotStatus(slotCount, EVAL_OK);
+        unsigned long long caseMismatches = 0;
+        for (size_t row = 0; row < rows; ++row) {
+            for (size_t i = 0; i < check.inputs; ++i) {
+                slots[i] = values[i][row];
+                if (check.interpreted) interpreter.setVariable(statements[i].name, slots[i].d);
+            }
+
+            for (size_t i = check.inputs; i < slotCount; ++i) {
+                slotStatus[i] = evaluator.run(expressions[i], slots.data(), slotStatus.data(), slots[i]);
+                std::string scalar = describe(slots[i], slotStatus[i], types[i]);
+                std::string mismatch;
+
+                if (slotStatus[i] != status[i][row] ||
+                    (slotStatus[i] == EVAL_OK && !sameValue(slots[i], values[i][row], types[i]))) {
+                    mismatch = "runBatch " + describe(values[i][row], status[i][row], types[i]);
+                }
+                if (check.interpreted) {
+                    double result = interpreter.evaluate(statements[i].postfix);
+                    Value interpreted;
+                    interpreted.d = result;
+                    uint8_t interpretedStatus = interpreter.getLastStatus();
+                    if (interpretedStatus != slotStatus[i] ||
+                        (slotStatus[i] == EVAL_OK && !sameValue(slots[i], interpreted, TYPE_DOUBLE))) {
+                        mismatch += " evaluate " + describe(interpreted, interpretedStatus, TYPE_DOUBLE);
+                    }
+                    interpreter.setVariable(statements[i].name, result);
+                }
+
+                if (!mismatch.empty() && caseMismatches++ < 8) {
+                    std::cout << "  " << statements[i].name << " row " << row << ": run " << scalar
+                              << ", " << mismatch << "\n";
+                }
+            }
+        }
+
+        std::cout << "case " << index + 1 << " (" << slotCount - check.inputs << " statements, "
+                  << rows << " rows" << (check.interpreted ? ", with evaluate" : "") << "): "
+                  << caseMismatches << " mismatches\n";
+        mismatches += caseMismatches;
+    }
+
+    return mismatches ? 1 : 0;
+}
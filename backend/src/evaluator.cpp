@@ -1,17 +1,233 @@
 #include "../include/evaluator.h"
+#include "../include/environment.h"
+#include "../include/profiler.h"
+#include <charconv>
+#include <chrono>
 #include <sstream>
 #include <cmath>
-#include <iostream>
+#include <cstring>
+#include <stdexcept>
 
-Evaluator::Evaluator() {}
+ValueType valueTypeOf(const std::string& keyword) {
+    if (keyword == "int") return TYPE_INT;
+    if (keyword == "float") return TYPE_FLOAT;
+    return TYPE_DOUBLE;
+}
+
+namespace {
+
+const double INT64_LIMIT = 9223372036854775808.0;   // 2^63
+
+// Conversions follow C, except that values an int64 cannot hold report
+// EVAL_OVERFLOW instead of being undefined
+template <typename T>
+EvalStatus toInt(T value, int64_t& out) {
+    if (value != value) {
+        EvalStatus status = evalErrorStatus(static_cast<double>(value));
+        return status == EVAL_OK ? EVAL_OVERFLOW : status;
+    }
+    if (!(value >= -INT64_LIMIT && value < INT64_LIMIT)) return EVAL_OVERFLOW;
+    out = static_cast<int64_t>(value);
+    return EVAL_OK;
+}
+
+EvalStatus convertValue(Value& value, ValueType from, ValueType to) {
+    if (from == to) return EVAL_OK;
+    switch (to) {
+        case TYPE_INT:
+            return from == TYPE_FLOAT ? toInt(value.f, value.i) : toInt(value.d, value.i);
+        case TYPE_FLOAT:
+            value.f = from == TYPE_INT ? static_cast<float>(value.i) : static_cast<float>(value.d);
+            return EVAL_OK;
+        case TYPE_DOUBLE:
+            value.d = from == TYPE_INT ? static_cast<double>(value.i) : static_cast<double>(value.f);
+            return EVAL_OK;
+    }
+    return EVAL_OK;
+}
+
+double toDouble(Value value, ValueType type) {
+    switch (type) {
+        case TYPE_INT: return static_cast<double>(value.i);
+        case TYPE_FLOAT: return static_cast<double>(value.f);
+        case TYPE_DOUBLE: return value.d;
+    }
+    return value.d;
+}
+
+EvalStatus powInt(int64_t base, int64_t exponent, int64_t& out) {
+    if (exponent < 0) {
+        // Integer result of base^-n is 0 unless |base| is 1
+        if (base == 0) return EVAL_DIVISION_BY_ZERO;
+        out = base == 1 ? 1 : base == -1 ? (exponent % 2 ? -1 : 1) : 0;
+        return EVAL_OK;
+    }
+
+    int64_t result = 1;
+    while (exponent > 0) {
+        if ((exponent & 1) && __builtin_mul_overflow(result, base, &result)) return EVAL_OVERFLOW;
+        exponent >>= 1;
+        if (exponent > 0 && __builtin_mul_overflow(base, base, &base)) return EVAL_OVERFLOW;
+    }
+    out = result;
+    return EVAL_OK;
+}
+
+EvalStatus applyInt(OpCode code, int64_t a, int64_t b, int64_t& out) {
+    switch (code) {
+        case OP_ADD: return __builtin_add_overflow(a, b, &out) ? EVAL_OVERFLOW : EVAL_OK;
+        case OP_SUB: return __builtin_sub_overflow(a, b, &out) ? EVAL_OVERFLOW : EVAL_OK;
+        case OP_MUL: return __builtin_mul_overflow(a, b, &out) ? EVAL_OVERFLOW : EVAL_OK;
+        case OP_DIV:
+            if (b == 0) return EVAL_DIVISION_BY_ZERO;
+            if (a == INT64_MIN && b == -1) return EVAL_OVERFLOW;
+            out = a / b;
+            return EVAL_OK;
+        case OP_MOD:
+            if (b == 0) return EVAL_MODULO_BY_ZERO;
+            out = b == -1 ? 0 : a % b;
+            return EVAL_OK;
+        case OP_POW: return powInt(a, b, out);
+        default: return EVAL_UNKNOWN_OPERATOR;
+    }
+}
+
+// `%` on floating operands truncates both to int64 first
+template <typename T>
+EvalStatus applyFloating(OpCode code, T a, T b, T& out) {
+    switch (code) {
+        case OP_ADD: out = a + b; return EVAL_OK;
+        case OP_SUB: out = a - b; return EVAL_OK;
+        case OP_MUL: out = a * b; return EVAL_OK;
+        case OP_DIV:
+            if (b == 0) return EVAL_DIVISION_BY_ZERO;
+            out = a / b;
+            return EVAL_OK;
+        case OP_MOD: {
+            int64_t x = 0, y = 0, remainder = 0;
+            EvalStatus status = toInt(a, x);
+            if (status == EVAL_OK) status = toInt(b, y);
+            if (status == EVAL_OK) status = y == 0 ? EVAL_MODULO_BY_ZERO : applyInt(OP_MOD, x, y, remainder);
+            if (status == EVAL_OK) out = static_cast<T>(remainder);
+            return status;
+        }
+        case OP_POW: out = std::pow(a, b); return EVAL_OK;
+        default: return EVAL_UNKNOWN_OPERATOR;
+    }
+}
+
+template <typename T>
+bool compareValues(OpCode code, T a, T b) {
+    switch (code) {
+        case OP_LT: return a < b;
+        case OP_GT: return a > b;
+        case OP_LE: return a <= b;
+        case OP_GE: return a >= b;
+        case OP_EQ: return a == b;
+        default: return a != b;
+    }
+}
+
+bool isTrue(const Value& value, ValueType type) {
+    switch (type) {
+        case TYPE_INT: return value.i != 0;
+        case TYPE_FLOAT: return value.f != 0;
+        case TYPE_DOUBLE: return value.d != 0;
+    }
+    return false;
+}
+
+bool isIntegerLiteral(const std::string& token) {
+    return token.find_first_of(".eE") == std::string::npos;
+}
+
+OpCode opCodeOf(const std::string& token) {
+    if (token == "+") return OP_ADD;
+    if (token == "-") return OP_SUB;
+    if (token == "*") return OP_MUL;
+    if (token == "/") return OP_DIV;
+    if (token == "%") return OP_MOD;
+    if (token == "^") return OP_POW;
+    if (token == "<") return OP_LT;
+    if (token == ">") return OP_GT;
+    if (token == "<=") return OP_LE;
+    if (token == ">=") return OP_GE;
+    if (token == "==") return OP_EQ;
+    if (token == "!=") return OP_NE;
+    if (token == "&&") return OP_AND;
+    return OP_OR;
+}
+
+bool isComparison(OpCode code) {
+    return code >= OP_LT && code <= OP_NE;
+}
+
+// Scalar code for one subexpression while compiling
+struct Fragment {
+    std::vector<Instruction> code;
+    ValueType type;
+};
+
+void appendCast(Fragment& fragment, ValueType to) {
+    if (fragment.type == to) return;
+    Instruction cast(OP_CAST, to);
+    cast.left = fragment.type;
+    fragment.code.push_back(cast);
+    fragment.type = to;
+}
+
+}
+
+EvalStatus valueFromDouble(double value, ValueType type, Value& out) {
+    // A NaN input has no int value, but it is not an overflow either
+    if (type == TYPE_INT && value != value) {
+        EvalStatus status = evalErrorStatus(value);
+        out.i = 0;
+        return status == EVAL_OK ? EVAL_INVALID_INPUT : status;
+    }
+    out.d = value;
+    EvalStatus status = convertValue(out, TYPE_DOUBLE, type);
+    if (status != EVAL_OK) out.i = 0;
+    return status;
+}
+
+double valueToDouble(const Value& value, ValueType type) {
+    return toDouble(value, type);
+}
+
+const char* parseValue(const char* first, const char* last, ValueType type,
+                       Value& out, EvalStatus& status) {
+    status = EVAL_OK;
+    if (type == TYPE_INT) {
+        // Plain integers skip the double so every int64 is read exactly
+        std::from_chars_result parsed = std::from_chars(first, last, out.i);
+        if (parsed.ec == std::errc() &&
+            (parsed.ptr == last || (*parsed.ptr != '.' && *parsed.ptr != 'e' && *parsed.ptr != 'E'))) {
+            return parsed.ptr;
+        }
+    }
+
+    double value;
+    std::from_chars_result parsed = std::from_chars(first, last, value);
+    if (parsed.ec != std::errc()) return nullptr;
+    status = valueFromDouble(value, type, out);
+    return parsed.ptr;
+}
+
+Evaluator::Evaluator()
+    : variables(new VariableEnvironment), profiler(nullptr), lastStatus(EVAL_OK) {}
+
+Evaluator::~Evaluator() {}
 
 void Evaluator::setVariable(const std::string& name, double value) {
-    variables[name] = value;
+    variables->declare(name, value);
 }
 
 bool Evaluator::isOperator(const std::string& token) {
     return token == "+" || token == "-" || token == "*" || token == "/" || 
-           token == "%" || token == "^";
+           token == "%" || token == "^" || token == "<" || token == ">" ||
+           token == "<=" || token == ">=" || token == "==" || token == "!=" ||
+           token == "&&" || token == "||";
 }
 
 bool Evaluator::isNumber(const std::string& token) {
@@ -24,48 +240,109 @@ bool Evaluator::isNumber(const std::string& token) {
     return iss.eof() && !iss.fail();
 }
 
-double Evaluator::applyOperator(const std::string& op, double a, double b) {
+namespace {
+
+// Most arithmetic keeps a NaN-boxed error as is, but pow(x, 0) is 1, %
+// goes through integers and comparisons yield 0 or 1, so operands are
+// checked first
+bool carryError(double a, double b, double& result) {
+    if (a == a && b == b) return false;
+    if (evalErrorStatus(a) != EVAL_OK) {
+        result = a;
+        return true;
+    }
+    if (evalErrorStatus(b) != EVAL_OK) {
+        result = b;
+        return true;
+    }
+    return false;
+}
+
+}
+
+double Evaluator::applyOperator(const std::string& op, double a, double b) const {
+    // When the left operand decides && or ||, compiled code never evaluates
+    // the right one, so its error does not count
+    if (op == "&&" && a == 0) return 0;
+    if (op == "||" && a != 0 && evalErrorStatus(a) == EVAL_OK) return 1;
+
+    double error;
+    if (carryError(a, b, error)) return error;
+
     if (op == "+") return a + b;
     if (op == "-") return a - b;
     if (op == "*") return a * b;
     if (op == "/") {
         if (b == 0) {
-            std::cerr << "Error: Division by zero!" << std::endl;
-            return 0;
+            if (profiler) profiler->recordError(evalStatusName(EVAL_DIVISION_BY_ZERO));
+            return evalErrorValue(EVAL_DIVISION_BY_ZERO);
         }
         return a / b;
     }
     if (op == "%") {
-        if (b == 0) {
-            std::cerr << "Error: Modulo by zero!" << std::endl;
-            return 0;
+        double remainder = 0;
+        EvalStatus status = applyFloating(OP_MOD, a, b, remainder);
+        if (status != EVAL_OK) {
+            if (profiler) profiler->recordError(evalStatusName(status));
+            return evalErrorValue(status);
         }
-        return static_cast<int>(a) % static_cast<int>(b);
+        return remainder;
     }
     if (op == "^") return std::pow(a, b);
+    if (op == "<") return a < b;
+    if (op == ">") return a > b;
+    if (op == "<=") return a <= b;
+    if (op == ">=") return a >= b;
+    if (op == "==") return a == b;
+    if (op == "!=") return a != b;
+    if (op == "&&") return a != 0 && b != 0;
+    if (op == "||") return a != 0 || b != 0;
     
-    std::cerr << "Error: Unknown operator '" << op << "'" << std::endl;
-    return 0;
+    if (profiler) profiler->recordError(evalStatusName(EVAL_UNKNOWN_OPERATOR));
+    return evalErrorValue(EVAL_UNKNOWN_OPERATOR);
 }
 
 double Evaluator::evaluatePostfix(const std::vector<std::string>& postfix) {
     std::stack<double> operandStack;
+    VariableEnvironment::ReadGuard guard = variables->read();
+    const std::map<std::string, size_t>& slots = *guard.get().slots;
     
-    for (const auto& token : postfix) {
+    for (size_t i = 0; i < postfix.size(); ++i) {
+        const std::string& token = postfix[i];
+        std::chrono::steady_clock::time_point start;
+        if (profiler) start = std::chrono::steady_clock::now();
+
         if (isNumber(token)) {
             // Convert string to number
             std::istringstream iss(token);
             double num;
             iss >> num;
             operandStack.push(num);
-        } else if (variables.find(token) != variables.end()) {
+        } else if (slots.find(token) != slots.end()) {
             // It's a variable, push its value
-            operandStack.push(variables[token]);
+            operandStack.push(guard.values()[slots.at(token)].d);
+        } else if (token == "?:") {
+            // Conditional: both branches are already on the stack
+            if (operandStack.size() < 3) {
+                if (profiler) profiler->recordError(evalStatusName(EVAL_NOT_ENOUGH_OPERANDS));
+                return evalErrorValue(EVAL_NOT_ENOUGH_OPERANDS);
+            }
+
+            double otherwise = operandStack.top(); operandStack.pop();
+            double then = operandStack.top(); operandStack.pop();
+            double condition = operandStack.top(); operandStack.pop();
+
+            // Only the condition and the chosen branch can fail the result
+            if (evalErrorStatus(condition) != EVAL_OK) {
+                operandStack.push(condition);
+            } else {
+                operandStack.push(condition != 0 ? then : otherwise);
+            }
         } else if (isOperator(token)) {
             // It's an operator, pop operands and apply
             if (operandStack.size() < 2) {
-                std::cerr << "Error: Not enough operands for operator '" << token << "'" << std::endl;
-                return 0;
+                if (profiler) profiler->recordError(evalStatusName(EVAL_NOT_ENOUGH_OPERANDS));
+                return evalErrorValue(EVAL_NOT_ENOUGH_OPERANDS);
             }
             
             double b = operandStack.top(); operandStack.pop();
@@ -74,27 +351,534 @@ double Evaluator::evaluatePostfix(const std::vector<std::string>& postfix) {
             double result = applyOperator(token, a, b);
             operandStack.push(result);
         } else {
-            std::cerr << "Error: Unknown token '" << token << "'" << std::endl;
-            return 0;
+            if (profiler) profiler->recordError(evalStatusName(EVAL_UNKNOWN_TOKEN));
+            return evalErrorValue(EVAL_UNKNOWN_TOKEN);
+        }
+
+        if (profiler) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            profiler->recordToken(i, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                                  operandStack.size());
         }
     }
     
     if (operandStack.size() != 1) {
-        std::cerr << "Error: Invalid expression - too many operands" << std::endl;
-        return 0;
+        if (profiler) profiler->recordError(evalStatusName(EVAL_TOO_MANY_OPERANDS));
+        return evalErrorValue(EVAL_TOO_MANY_OPERANDS);
     }
     
     return operandStack.top();
 }
 
 double Evaluator::evaluate(const std::vector<std::string>& postfix) {
-    return evaluatePostfix(postfix);
+    double result;
+    if (profiler) {
+        profiler->beginRun(postfix);
+        result = evaluatePostfix(postfix);
+        profiler->endRun();
+    } else {
+        result = evaluatePostfix(postfix);
+    }
+
+    lastStatus = evalErrorStatus(result);
+    if (lastStatus != EVAL_OK) {
+        errors.record(lastStatus);
+        if (errors.shouldSample(lastStatus)) {
+            std::string expression;
+            for (const auto& token : postfix) {
+                if (!expression.empty()) expression += " ";
+                expression += token;
+            }
+            errors.addSample(lastStatus, std::string(evalStatusName(lastStatus)) + " in '" + expression + "'");
+        }
+    }
+    return result;
+}
+
+EvalStatus Evaluator::getLastStatus() const {
+    return lastStatus;
+}
+
+const ErrorLog& Evaluator::getErrors() const {
+    return errors;
 }
 
-std::map<std::string, double> Evaluator::getVariables() {
-    return variables;
+std::map<std::string, double> Evaluator::getVariables() const {
+    VariableEnvironment::ReadGuard guard = variables->read();
+    std::map<std::string, double> values;
+    for (const auto& entry : *guard.get().slots) {
+        values[entry.first] = guard.values()[entry.second].d;
+    }
+    return values;
+}
+
+VariableEnvironment& Evaluator::getEnvironment() {
+    return *variables;
 }
 
 void Evaluator::clearVariables() {
-    variables.clear();
-} 
\ No newline at end of file
+    variables.reset(new VariableEnvironment);
+}
+
+void Evaluator::setProfiler(Profiler* profiler) {
+    this->profiler = profiler;
+}
+
+CompiledExpression Evaluator::compile(const std::vector<std::string>& postfix,
+                                      const std::map<std::string, size_t>& slots,
+                                      ValueType resultType,
+                                      const std::vector<ValueType>& slotTypes) {
+    CompiledExpression compiled;
+    std::vector<Fragment> fragments;
+    compiled.maxDepth = 0;
+    compiled.resultType = resultType;
+
+    for (const auto& token : postfix) {
+        Fragment fragment;
+
+        if (isNumber(token)) {
+            Instruction instruction(OP_PUSH, TYPE_DOUBLE);
+            instruction.value.d = std::stod(token);
+            int64_t integer;
+            if (isIntegerLiteral(token) &&
+                std::from_chars(token.data(), token.data() + token.size(), integer).ec == std::errc()) {
+                instruction.type = TYPE_INT;
+                instruction.value.i = integer;
+            }
+            compiled.batchCode.push_back(instruction);
+            fragment.code.push_back(instruction);
+            fragment.type = instruction.type;
+        } else if (slots.find(token) != slots.end()) {
+            size_t slot = slots.at(token);
+            Instruction instruction(OP_LOAD, slot < slotTypes.size() ? slotTypes[slot] : TYPE_DOUBLE);
+            instruction.slot = slot;
+            compiled.batchCode.push_back(instruction);
+            fragment.code.push_back(instruction);
+            fragment.type = instruction.type;
+        } else if (token == "?:") {
+            if (fragments.size() < 3) {
+                throw std::runtime_error("Not enough operands for operator '?:'");
+            }
+            Fragment otherwise = fragments.back(); fragments.pop_back();
+            Fragment then = fragments.back(); fragments.pop_back();
+            Fragment condition = fragments.back(); fragments.pop_back();
+
+            Instruction select(OP_SELECT, then.type > otherwise.type ? then.type : otherwise.type);
+            select.left = then.type;
+            select.right = otherwise.type;
+            select.test = condition.type;
+            compiled.batchCode.push_back(select);
+
+            // condition, jump-if-false over then-branch, then, jump over else-branch, else
+            appendCast(then, select.type);
+            appendCast(otherwise, select.type);
+            Instruction skipThen(OP_JUMP_IF_FALSE, condition.type);
+            skipThen.slot = then.code.size() + 1;
+            Instruction skipElse(OP_JUMP, select.type);
+            skipElse.slot = otherwise.code.size();
+
+            fragment.code = condition.code;
+            fragment.code.push_back(skipThen);
+            fragment.code.insert(fragment.code.end(), then.code.begin(), then.code.end());
+            fragment.code.push_back(skipElse);
+            fragment.code.insert(fragment.code.end(), otherwise.code.begin(), otherwise.code.end());
+            fragment.type = select.type;
+        } else if (isOperator(token)) {
+            if (fragments.size() < 2) {
+                throw std::runtime_error("Not enough operands for operator '" + token + "'");
+            }
+            Fragment right = fragments.back(); fragments.pop_back();
+            Fragment left = fragments.back(); fragments.pop_back();
+
+            OpCode code = opCodeOf(token);
+            ValueType common = left.type > right.type ? left.type : right.type;
+            bool logical = code == OP_AND || code == OP_OR;
+            Instruction instruction(code, isComparison(code) || logical ? TYPE_INT : common);
+            instruction.left = left.type;
+            instruction.right = right.type;
+            instruction.test = common;
+            compiled.batchCode.push_back(instruction);
+
+            fragment.code = left.code;
+            if (logical) {
+                // Skip the right operand once the left one decides the result
+                Instruction shortCircuit(code == OP_AND ? OP_AND_JUMP : OP_OR_JUMP, TYPE_INT);
+                shortCircuit.test = left.type;
+                shortCircuit.slot = right.code.size() + 1;
+                fragment.code.push_back(shortCircuit);
+            }
+            fragment.code.insert(fragment.code.end(), right.code.begin(), right.code.end());
+            fragment.code.push_back(instruction);
+            fragment.type = instruction.type;
+        } else {
+            throw std::runtime_error("Unknown token '" + token + "'");
+        }
+
+        fragments.push_back(fragment);
+        if (fragments.size() > compiled.maxDepth) compiled.maxDepth = fragments.size();
+    }
+
+    if (fragments.size() != 1) {
+        throw std::runtime_error("Invalid expression - too many operands");
+    }
+    compiled.code = fragments[0].code;
+    compiled.type = fragments[0].type;
+
+    return compiled;
+}
+
+EvalStatus Evaluator::run(const CompiledExpression& expression, const Value* slots,
+                          const uint8_t* slotStatus, Value& result) const {
+    // Small programs run on a fixed buffer so the hot path never allocates
+    Value buffer[64];
+    std::vector<Value> overflow;
+    Value* stack = buffer;
+    if (expression.maxDepth > 64) {
+        overflow.resize(expression.maxDepth);
+        stack = overflow.data();
+    }
+
+    size_t top = 0;
+    EvalStatus status = EVAL_OK;
+    const std::vector<Instruction>& code = expression.code;
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        const Instruction& instruction = code[pc];
+        switch (instruction.code) {
+            case OP_PUSH:
+                stack[top++] = instruction.value;
+                break;
+            case OP_LOAD:
+                // Slots already hold the load type; carry errors from earlier statements
+                if (slotStatus && slotStatus[instruction.slot] != EVAL_OK) {
+                    return static_cast<EvalStatus>(slotStatus[instruction.slot]);
+                }
+                stack[top++] = slots[instruction.slot];
+                break;
+            case OP_CAST:
+                status = convertValue(stack[top - 1], instruction.left, instruction.type);
+                break;
+            case OP_JUMP:
+                pc += instruction.slot;
+                break;
+            case OP_JUMP_IF_FALSE:
+                top--;
+                if (!isTrue(stack[top], instruction.test)) pc += instruction.slot;
+                break;
+            case OP_AND_JUMP:
+                if (!isTrue(stack[top - 1], instruction.test)) {
+                    stack[top - 1].i = 0;
+                    pc += instruction.slot;
+                }
+                break;
+            case OP_OR_JUMP:
+                if (isTrue(stack[top - 1], instruction.test)) {
+                    stack[top - 1].i = 1;
+                    pc += instruction.slot;
+                }
+                break;
+            case OP_AND:
+            case OP_OR: {
+                top--;
+                bool a = isTrue(stack[top - 1], instruction.left);
+                bool b = isTrue(stack[top], instruction.right);
+                stack[top - 1].i = instruction.code == OP_AND ? (a && b) : (a || b);
+                break;
+            }
+            case OP_SELECT:
+                status = EVAL_UNKNOWN_OPERATOR;
+                break;
+            default: {
+                top--;
+                Value& a = stack[top - 1];
+                Value b = stack[top];
+                status = convertValue(a, instruction.left, instruction.test);
+                if (status == EVAL_OK) status = convertValue(b, instruction.right, instruction.test);
+                if (status != EVAL_OK) break;
+
+                if (isComparison(instruction.code)) {
+                    switch (instruction.test) {
+                        case TYPE_INT: a.i = compareValues(instruction.code, a.i, b.i); break;
+                        case TYPE_FLOAT: a.i = compareValues(instruction.code, a.f, b.f); break;
+                        case TYPE_DOUBLE: a.i = compareValues(instruction.code, a.d, b.d); break;
+                    }
+                    break;
+                }
+
+                switch (instruction.type) {
+                    case TYPE_INT: status = applyInt(instruction.code, a.i, b.i, a.i); break;
+                    case TYPE_FLOAT: status = applyFloating(instruction.code, a.f, b.f, a.f); break;
+                    case TYPE_DOUBLE: status = applyFloating(instruction.code, a.d, b.d, a.d); break;
+                }
+                break;
+            }
+        }
+
+        if (status != EVAL_OK) return status;
+    }
+
+    status = convertValue(stack[0], expression.type, expression.resultType);
+    if (status == EVAL_OK) result = stack[0];
+    return status;
+}
+
+namespace {
+
+// One stack entry of a batch: a value and the first error of every row.
+// `clean` lanes have no errors and leave `status` unset, so error-free
+// batches never touch it.
+struct alignas(64) Lane {
+    union {
+        int64_t i[EVAL_BATCH_SIZE];
+        float f[EVAL_BATCH_SIZE];
+        double d[EVAL_BATCH_SIZE];
+    };
+    uint8_t status[EVAL_BATCH_SIZE];
+    bool clean;
+};
+
+inline void trackErrors(Lane& lane, size_t count) {
+    if (!lane.clean) return;
+    std::memset(lane.status, EVAL_OK, count);
+    lane.clean = false;
+}
+
+// Records the first error of each row; later ones are ignored
+inline void flagRow(uint8_t* status, size_t row, EvalStatus error) {
+    if (status[row] == EVAL_OK) status[row] = static_cast<uint8_t>(error);
+}
+
+// Rows where `into` has no error yet take the error of `from`
+void mergeStatus(Lane& into, const Lane& from, size_t count) {
+    if (from.clean) return;
+    trackErrors(into, count);
+    for (size_t i = 0; i < count; ++i) into.status[i] = into.status[i] ? into.status[i] : from.status[i];
+}
+
+template <typename T>
+void convertLane(const T* from, Lane& to, ValueType type, size_t count, uint8_t* status) {
+    switch (type) {
+        case TYPE_INT:
+            for (size_t i = 0; i < count; ++i) {
+                EvalStatus error = toInt(from[i], to.i[i]);
+                if (error != EVAL_OK) {
+                    to.i[i] = 0;
+                    flagRow(status, i, error);
+                }
+            }
+            break;
+        case TYPE_FLOAT:
+            for (size_t i = 0; i < count; ++i) to.f[i] = static_cast<float>(from[i]);
+            break;
+        case TYPE_DOUBLE:
+            for (size_t i = 0; i < count; ++i) to.d[i] = static_cast<double>(from[i]);
+            break;
+    }
+}
+
+// Values are converted through `scratch`; the lane keeps its own status
+void convertLane(Lane& lane, ValueType from, ValueType to, Lane& scratch, size_t count) {
+    if (from == to) return;
+    if (to == TYPE_INT) trackErrors(lane, count);
+    switch (from) {
+        case TYPE_INT: convertLane(lane.i, scratch, to, count, lane.status); break;
+        case TYPE_FLOAT: convertLane(lane.f, scratch, to, count, lane.status); break;
+        case TYPE_DOUBLE: convertLane(lane.d, scratch, to, count, lane.status); break;
+    }
+    std::memcpy(lane.d, scratch.d, sizeof(lane.d));
+}
+
+template <typename T>
+void truthLane(const T* lane, uint8_t* mask, size_t count) {
+    for (size_t i = 0; i < count; ++i) mask[i] = lane[i] != 0;
+}
+
+void truthLane(const Lane& lane, ValueType type, uint8_t* mask, size_t count) {
+    switch (type) {
+        case TYPE_INT: truthLane(lane.i, mask, count); break;
+        case TYPE_FLOAT: truthLane(lane.f, mask, count); break;
+        case TYPE_DOUBLE: truthLane(lane.d, mask, count); break;
+    }
+}
+
+template <typename T>
+void compareLane(OpCode code, const T* a, const T* b, int64_t* out, size_t count) {
+    switch (code) {
+        case OP_LT: for (size_t i = 0; i < count; ++i) out[i] = a[i] < b[i]; break;
+        case OP_GT: for (size_t i = 0; i < count; ++i) out[i] = a[i] > b[i]; break;
+        case OP_LE: for (size_t i = 0; i < count; ++i) out[i] = a[i] <= b[i]; break;
+        case OP_GE: for (size_t i = 0; i < count; ++i) out[i] = a[i] >= b[i]; break;
+        case OP_EQ: for (size_t i = 0; i < count; ++i) out[i] = a[i] == b[i]; break;
+        default: for (size_t i = 0; i < count; ++i) out[i] = a[i] != b[i]; break;
+    }
+}
+
+// Branch-free select: both branches were computed for every row
+template <typename T>
+void blendLane(const uint8_t* mask, const T* then, const T* otherwise, T* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] = mask[i] ? then[i] : otherwise[i];
+}
+
+// Plain element-wise loops so the compiler can vectorize them; float32
+// lanes fit twice as many values per register as double
+template <typename T>
+void applyFloatingLane(OpCode code, T* a, const T* b, size_t count, Lane& lane) {
+    switch (code) {
+        case OP_ADD: for (size_t i = 0; i < count; ++i) a[i] = a[i] + b[i]; break;
+        case OP_SUB: for (size_t i = 0; i < count; ++i) a[i] = a[i] - b[i]; break;
+        case OP_MUL: for (size_t i = 0; i < count; ++i) a[i] = a[i] * b[i]; break;
+        case OP_DIV: {
+            bool anyZero = false;
+            for (size_t i = 0; i < count; ++i) anyZero |= b[i] == 0;
+            for (size_t i = 0; i < count; ++i) a[i] = b[i] == 0 ? T(0) : a[i] / b[i];
+            if (anyZero) {
+                trackErrors(lane, count);
+                for (size_t i = 0; i < count; ++i) {
+                    if (b[i] == 0) flagRow(lane.status, i, EVAL_DIVISION_BY_ZERO);
+                }
+            }
+            break;
+        }
+        default:
+            trackErrors(lane, count);
+            for (size_t i = 0; i < count; ++i) {
+                EvalStatus error = applyFloating(code, a[i], b[i], a[i]);
+                if (error != EVAL_OK) flagRow(lane.status, i, error);
+            }
+            break;
+    }
+}
+
+void applyIntLane(OpCode code, int64_t* a, const int64_t* b, size_t count, Lane& lane) {
+    trackErrors(lane, count);
+    uint8_t* status = lane.status;
+    for (size_t i = 0; i < count; ++i) {
+        int64_t result = 0;
+        EvalStatus error = applyInt(code, a[i], b[i], result);
+        a[i] = result;
+        if (error != EVAL_OK) flagRow(status, i, error);
+    }
+}
+
+}
+
+void Evaluator::runBatch(const CompiledExpression& expression, const SlotColumn* columns,
+                         size_t count, Value* out, uint8_t* status) const {
+    thread_local std::vector<Lane> stack;
+    thread_local Lane scratch;
+    if (stack.size() < expression.maxDepth) stack.resize(expression.maxDepth);
+
+    uint8_t mask[EVAL_BATCH_SIZE];
+    uint8_t other[EVAL_BATCH_SIZE];
+    size_t top = 0;
+
+    for (const auto& instruction : expression.batchCode) {
+        if (instruction.code == OP_PUSH) {
+            Lane& lane = stack[top++];
+            lane.clean = true;
+            switch (instruction.type) {
+                case TYPE_INT: for (size_t i = 0; i < count; ++i) lane.i[i] = instruction.value.i; break;
+                case TYPE_FLOAT: for (size_t i = 0; i < count; ++i) lane.f[i] = static_cast<float>(instruction.value.d); break;
+                case TYPE_DOUBLE: for (size_t i = 0; i < count; ++i) lane.d[i] = instruction.value.d; break;
+            }
+        } else if (instruction.code == OP_LOAD) {
+            const SlotColumn& column = columns[instruction.slot];
+            Lane& lane = stack[top++];
+            lane.clean = true;
+
+            // Carry errors from earlier statements into this row's status
+            if (column.status) {
+                uint8_t any = 0;
+                for (size_t i = 0; i < count; ++i) any |= column.status[i];
+                if (any) {
+                    trackErrors(lane, count);
+                    std::memcpy(lane.status, column.status, count);
+                }
+            }
+            switch (instruction.type) {
+                case TYPE_INT: for (size_t i = 0; i < count; ++i) lane.i[i] = column.values[i].i; break;
+                case TYPE_FLOAT: for (size_t i = 0; i < count; ++i) lane.f[i] = column.values[i].f; break;
+                case TYPE_DOUBLE: for (size_t i = 0; i < count; ++i) lane.d[i] = column.values[i].d; break;
+            }
+        } else if (instruction.code == OP_SELECT) {
+            top -= 2;
+            Lane& condition = stack[top - 1];
+            Lane& then = stack[top];
+            Lane& otherwise = stack[top + 1];
+            convertLane(then, instruction.left, instruction.type, scratch, count);
+            convertLane(otherwise, instruction.right, instruction.type, scratch, count);
+            truthLane(condition, instruction.test, mask, count);
+
+            // Only the chosen branch's errors count for a row
+            if (!then.clean || !otherwise.clean) {
+                trackErrors(then, count);
+                trackErrors(otherwise, count);
+                trackErrors(condition, count);
+                for (size_t i = 0; i < count; ++i) {
+                    uint8_t chosen = mask[i] ? then.status[i] : otherwise.status[i];
+                    condition.status[i] = condition.status[i] ? condition.status[i] : chosen;
+                }
+            }
+            switch (instruction.type) {
+                case TYPE_INT: blendLane(mask, then.i, otherwise.i, condition.i, count); break;
+                case TYPE_FLOAT: blendLane(mask, then.f, otherwise.f, condition.f, count); break;
+                case TYPE_DOUBLE: blendLane(mask, then.d, otherwise.d, condition.d, count); break;
+            }
+        } else if (instruction.code == OP_AND || instruction.code == OP_OR) {
+            top--;
+            Lane& a = stack[top - 1];
+            Lane& b = stack[top];
+            truthLane(a, instruction.left, mask, count);
+            truthLane(b, instruction.right, other, count);
+
+            // The right operand's errors only count where it would be evaluated
+            bool isAnd = instruction.code == OP_AND;
+            if (!b.clean) {
+                trackErrors(a, count);
+                for (size_t i = 0; i < count; ++i) {
+                    uint8_t needed = isAnd ? mask[i] : !mask[i];
+                    a.status[i] = a.status[i] ? a.status[i] : (needed ? b.status[i] : 0);
+                }
+            }
+            for (size_t i = 0; i < count; ++i) {
+                a.i[i] = isAnd ? (mask[i] & other[i]) : (mask[i] | other[i]);
+            }
+        } else {
+            top--;
+            Lane& a = stack[top - 1];
+            Lane& b = stack[top];
+            convertLane(a, instruction.left, instruction.test, scratch, count);
+            convertLane(b, instruction.right, instruction.test, scratch, count);
+            mergeStatus(a, b, count);
+
+            if (isComparison(instruction.code)) {
+                switch (instruction.test) {
+                    case TYPE_INT: compareLane(instruction.code, a.i, b.i, scratch.i, count); break;
+                    case TYPE_FLOAT: compareLane(instruction.code, a.f, b.f, scratch.i, count); break;
+                    case TYPE_DOUBLE: compareLane(instruction.code, a.d, b.d, scratch.i, count); break;
+                }
+                std::memcpy(a.i, scratch.i, count * sizeof(int64_t));
+                continue;
+            }
+
+            switch (instruction.type) {
+                case TYPE_INT: applyIntLane(instruction.code, a.i, b.i, count, a); break;
+                case TYPE_FLOAT: applyFloatingLane(instruction.code, a.f, b.f, count, a); break;
+                case TYPE_DOUBLE: applyFloatingLane(instruction.code, a.d, b.d, count, a); break;
+            }
+        }
+    }
+
+    Lane& result = stack[0];
+    convertLane(result, expression.type, expression.resultType, scratch, count);
+    switch (expression.resultType) {
+        case TYPE_INT: for (size_t i = 0; i < count; ++i) out[i].i = result.i[i]; break;
+        case TYPE_FLOAT: for (size_t i = 0; i < count; ++i) out[i].f = result.f[i]; break;
+        case TYPE_DOUBLE: for (size_t i = 0; i < count; ++i) out[i].d = result.d[i]; break;
+    }
+
+    if (result.clean) {
+        std::memset(status, EVAL_OK, count);
+    } else {
+        std::memcpy(status, result.status, count);
+    }
+}
@@ -1,18 +1,28 @@
 #include "../include/lexer.h"
 #include "../include/parser.h"
 #include "../include/evaluator.h"
+#include "../include/program.h"
+#include "../include/shm_server.h"
+#include "../include/profiler.h"
+#include "../include/dataset.h"
+#include <fstream>
+#include <csignal>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <iomanip>
+#include <limits>
 #include <cctype>
+#include <algorithm>
+#include <cstdlib>
 
 class ArithmeticEvaluator {
 private:
     Lexer lexer;
     Parser parser;
     Evaluator evaluator;
+    std::string input;
     std::vector<std::string> lines;
 
     struct ExpressionInfo {
@@ -25,7 +35,8 @@ private:
     };
 
 public:
-    ArithmeticEvaluator(const std::string& source) : lexer(source) {
+    ArithmeticEvaluator(const std::string& source)
+        : lexer(source), parser(std::vector<Token>()), input(source) {
         std::istringstream iss(source);
         std::string line;
         while (std::getline(iss, line)) {
@@ -133,21 +144,41 @@ public:
                 }
             }
             
-            // Show arithmetic results
-            if (!expression.empty()) {
-                // Convert postfix string back to vector
-                std::vector<std::string> postfixTokens;
-                std::istringstream iss(postfix);
-                std::string token;
-                while (iss >> token) {
-                    postfixTokens.push_back(token);
-                }
-                
+            // Show arithmetic results, computed in each declaration's own type
+            Program program(input);
+            const std::vector<Statement>& statements = program.getStatements();
+            std::vector<ValueType> slotTypes = program.getSlotTypes();
+            std::vector<Value> slots(statements.size());
+            std::vector<uint8_t> slotStatus(statements.size(), EVAL_OK);
+            std::map<std::string, size_t> visible;
+
+            for (size_t i = 0; i < statements.size(); ++i) {
+                const Statement& statement = statements[i];
                 try {
-                    double result = evaluator.evaluate(postfixTokens);
-                    std::cout << "Arithmetic Result: " << result << "\n";
+                    CompiledExpression compiled = evaluator.compile(statement.postfix, visible,
+                                                                    valueTypeOf(statement.type), slotTypes);
+                    slotStatus[i] = evaluator.run(compiled, slots.data(), slotStatus.data(), slots[i]);
+                    visible[statement.name] = i;
                 } catch (const std::exception& e) {
-                    std::cout << "Expression: " << postfix << " (cannot evaluate)\n";
+                    std::cout << statement.type << " " << statement.name << " (cannot evaluate)\n";
+                    continue;
+                }
+                if (statement.isLiteral()) continue;
+
+                EvalStatus status = static_cast<EvalStatus>(slotStatus[i]);
+                ValueType type = valueTypeOf(statement.type);
+                std::cout << "Arithmetic Result: " << statement.type << " " << statement.name << " = ";
+                if (status != EVAL_OK) {
+                    std::cout << "error (" << evalStatusName(status) << ")\n";
+                } else if (type == TYPE_INT) {
+                    std::cout << slots[i].i << "\n";
+                } else {
+                    // Enough digits to read the same float or double back
+                    std::ostringstream text;
+                    text << std::setprecision(type == TYPE_FLOAT ? std::numeric_limits<float>::max_digits10
+                                                                 : std::numeric_limits<double>::max_digits10)
+                         << valueToDouble(slots[i], type);
+                    std::cout << text.str() << "\n";
                 }
             }
         } else {
@@ -158,7 +189,137 @@ public:
     }
 };
 
-int main() {
+static ShmServer* activeServer = nullptr;
+
+static void stopServer(int) {
+    if (activeServer) activeServer->stop();
+}
+
+static int runDaemon(const std::string& name, const std::string& input) {
+    Program program(input);
+    ShmServer server(name, program);
+    activeServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+
+    std::cout << "Serving " << program.getStatements().size() << " expressions ("
+              << program.getInputs().size() << " inputs) on " << name << "\n";
+    for (size_t i = 0; i < program.getStatements().size(); ++i) {
+        const Statement& statement = program.getStatements()[i];
+        std::cout << "  [" << i << "] " << statement.type << " " << statement.name
+                  << (statement.isLiteral() ? " (input)" : "") << "\n";
+    }
+    std::cout.flush();
+
+    server.serve();
+    activeServer = nullptr;
+    server.getErrors().write(std::cerr);
+    return 0;
+}
+
+static int runProfile(const std::string& foldedPath, int runs, const std::string& input) {
+    Program program(input);
+    Profiler profiler;
+    Evaluator evaluator;
+    evaluator.setProfiler(&profiler);
+
+    for (int run = 0; run < runs; ++run) {
+        for (const auto& statement : program.getStatements()) {
+            profiler.beginStatement(statement.name);
+            evaluator.setVariable(statement.name, evaluator.evaluate(statement.postfix));
+        }
+    }
+
+    std::cout << "\n=== Expression Profile (" << runs << " runs) ===\n\n";
+    profiler.writeAnnotated(std::cout);
+
+    std::ofstream folded(foldedPath);
+    if (!folded) {
+        throw std::runtime_error("Cannot write folded stacks to " + foldedPath);
+    }
+    profiler.writeFolded(folded);
+    std::cout << "\nFolded stacks written to " << foldedPath << "\n";
+    return 0;
+}
+
+static std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream iss(list);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+static int runDataset(int argc, char* argv[], const std::string& input) {
+    DatasetOptions options;
+    options.path = argv[2];
+    for (int i = 3; i < argc; i += 2) {
+        std::string flag = argv[i];
+        if (flag != "--binary" && flag != "--threads") {
+            throw std::runtime_error("Unknown dataset option " + flag);
+        }
+        if (i + 1 >= argc) {
+            throw std::runtime_error("Dataset option " + flag + " needs a value");
+        }
+
+        if (flag == "--binary") {
+            options.binary = true;
+            options.columns = splitList(argv[i + 1]);
+        } else {
+            options.threads = std::max(1, std::atoi(argv[i + 1]));
+        }
+    }
+
+    Program program(input);
+    DatasetRunner runner;
+    runner.run(program, options, std::cout);
+
+    std::cerr << "Processed " << runner.getRows() << " rows\n";
+    runner.getErrors().write(std::cerr);
+    if (runner.getBadFields() > 0) {
+        std::cerr << "Warning: " << runner.getBadFields() << " fields could not be read\n";
+    }
+    return 0;
+}
+
+static std::string readInput() {
+    std::string input;
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        input += line + "\n";
+    }
+    return input;
+}
+
+int main(int argc, char* argv[]) {
+    std::string mode = argc > 1 ? argv[1] : "";
+
+    if (mode == "--daemon" || mode == "--profile" || mode == "--dataset") {
+        if (argc < 3) {
+            std::cerr << "Usage: " << argv[0] << " --daemon <name>\n"
+                      << "       " << argv[0] << " --profile <folded-file> [runs]\n"
+                      << "       " << argv[0] << " --dataset <file> [--binary a,b,...] [--threads n]"
+                      << std::endl;
+            return 1;
+        }
+
+        try {
+            if (mode == "--daemon") {
+                return runDaemon(argv[2], readInput());
+            }
+            if (mode == "--dataset") {
+                return runDataset(argc, argv, readInput());
+            }
+            int runs = argc > 3 ? std::max(1, std::atoi(argv[3])) : 1;
+            return runProfile(argv[2], runs, readInput());
+        } catch (const std::exception& e) {
+            std::cerr << "\n❌ Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     std::cout << "Mini Arithmetic Expression Evaluator using C++\n";
     std::cout << "==============================================\n\n";
     
@@ -172,12 +333,7 @@ int main() {
     std::cout << "char c = 'A';\n";
     std::cout << "int sum = a + b * 2;\n\n";
     
-    std::string input;
-    std::string line;
-    
-    while (std::getline(std::cin, line)) {
-        input += line + "\n";
-    }
+    std::string input = readInput();
     
     if (input.empty()) {
         // Use default example if no input
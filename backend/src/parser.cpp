@@ -7,19 +7,32 @@ Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens), current(0) {
 }
 
 void Parser::initializePrecedence() {
-    precedence["+"] = 1;
-    precedence["-"] = 1;
-    precedence["*"] = 2;
-    precedence["/"] = 2;
-    precedence["%"] = 2;
-    precedence["^"] = 3;
+    precedence["?"] = 1;
+    precedence["?:"] = 1;
+    precedence["||"] = 2;
+    precedence["&&"] = 3;
+    precedence["=="] = 4;
+    precedence["!="] = 4;
+    precedence["<"] = 5;
+    precedence[">"] = 5;
+    precedence["<="] = 5;
+    precedence[">="] = 5;
+    precedence["+"] = 6;
+    precedence["-"] = 6;
+    precedence["*"] = 7;
+    precedence["/"] = 7;
+    precedence["%"] = 7;
+    precedence["^"] = 8;
     precedence["("] = 0;
     precedence[")"] = 0;
 }
 
 bool Parser::isOperator(const std::string& token) {
     return token == "+" || token == "-" || token == "*" || token == "/" || 
-           token == "%" || token == "^" || token == "(" || token == ")";
+           token == "%" || token == "^" || token == "(" || token == ")" ||
+           token == "<" || token == ">" || token == "<=" || token == ">=" ||
+           token == "==" || token == "!=" || token == "&&" || token == "||" ||
+           token == "?" || token == ":";
 }
 
 bool Parser::isOperand(const std::string& token) {
@@ -57,6 +70,25 @@ std::string Parser::infixToPostfix(const std::vector<std::string>& expression) {
             if (!operatorStack.empty() && operatorStack.top() == "(") {
                 operatorStack.pop(); // Remove '('
             }
+        } else if (token == "?") {
+            // Conditional is right-associative: only pop tighter operators
+            while (!operatorStack.empty() && 
+                   operatorStack.top() != "(" && 
+                   getPrecedence(operatorStack.top()) > getPrecedence(token)) {
+                output.push_back(operatorStack.top());
+                operatorStack.pop();
+            }
+            operatorStack.push(token);
+        } else if (token == ":") {
+            // Close the then-branch; `c ? a : b` becomes `c a b ?:`
+            while (!operatorStack.empty() && operatorStack.top() != "?" && operatorStack.top() != "(") {
+                output.push_back(operatorStack.top());
+                operatorStack.pop();
+            }
+            if (!operatorStack.empty() && operatorStack.top() == "?") {
+                operatorStack.pop();
+                operatorStack.push("?:");
+            }
         } else if (isOperator(token)) {
             while (!operatorStack.empty() && 
                    operatorStack.top() != "(" && 
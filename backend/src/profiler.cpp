@@ -0,0 +1,116 @@
+#include "../include/profiler.h"
+#include <stack>
+
+Profiler::Profiler() : label("expression"), active(nullptr) {}
+
+int Profiler::operandCount(const std::string& token) {
+    if (token == "?:") return 3;
+    if (token == "+" || token == "-" || token == "*" || token == "/" || token == "%" ||
+        token == "^" || token == "<" || token == ">" || token == "<=" || token == ">=" ||
+        token == "==" || token == "!=" || token == "&&" || token == "||") {
+        return 2;
+    }
+    return 0;
+}
+
+void Profiler::beginStatement(const std::string& label) {
+    this->label = label;
+}
+
+StatementProfile& Profiler::findStatement(const std::vector<std::string>& postfix) {
+    for (auto& statement : statements) {
+        if (statement.label == label && statement.tokens.size() == postfix.size()) {
+            return statement;
+        }
+    }
+
+    StatementProfile statement;
+    statement.label = label;
+    statement.runs = 0;
+    statement.nanoseconds = 0;
+    statement.maxDepth = 0;
+
+    // Link every token to the operator that consumes it so the folded
+    // output nests operands under their operators
+    std::stack<size_t> pending;
+    for (size_t i = 0; i < postfix.size(); ++i) {
+        TokenProfile token;
+        token.token = postfix[i];
+        token.parent = -1;
+        token.calls = 0;
+        token.nanoseconds = 0;
+        statement.tokens.push_back(token);
+
+        int operands = operandCount(postfix[i]);
+        if (operands > 0) {
+            for (int operand = 0; operand < operands && !pending.empty(); ++operand) {
+                statement.tokens[pending.top()].parent = static_cast<int>(i);
+                pending.pop();
+            }
+        }
+        pending.push(i);
+    }
+
+    statements.push_back(statement);
+    return statements.back();
+}
+
+void Profiler::beginRun(const std::vector<std::string>& postfix) {
+    active = &findStatement(postfix);
+    active->runs++;
+    runStart = std::chrono::steady_clock::now();
+}
+
+void Profiler::endRun() {
+    if (!active) return;
+    auto elapsed = std::chrono::steady_clock::now() - runStart;
+    active->nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    active = nullptr;
+}
+
+void Profiler::recordToken(size_t position, unsigned long long nanoseconds, size_t depth) {
+    if (!active || position >= active->tokens.size()) return;
+    active->tokens[position].calls++;
+    active->tokens[position].nanoseconds += nanoseconds;
+    if (depth > active->maxDepth) active->maxDepth = depth;
+}
+
+void Profiler::recordError(const std::string& kind) {
+    if (!active) return;
+    active->errors[kind]++;
+}
+
+void Profiler::writeAnnotated(std::ostream& out) const {
+    for (const auto& statement : statements) {
+        out << statement.label << ": " << statement.runs << " runs, "
+            << statement.nanoseconds << " ns, max stack depth " << statement.maxDepth << "\n";
+
+        out << "  ";
+        for (size_t i = 0; i < statement.tokens.size(); ++i) {
+            const TokenProfile& token = statement.tokens[i];
+            if (i > 0) out << " ";
+            out << token.token << "{" << token.calls << "x " << token.nanoseconds << "ns}";
+        }
+        out << "\n";
+
+        for (const auto& error : statement.errors) {
+            out << "  error: " << error.first << " x" << error.second << "\n";
+        }
+    }
+}
+
+void Profiler::writeFolded(std::ostream& out) const {
+    // One line per token: statement;outer operator;...;token <self nanoseconds>
+    for (const auto& statement : statements) {
+        for (size_t i = 0; i < statement.tokens.size(); ++i) {
+            const TokenProfile& token = statement.tokens[i];
+            if (token.nanoseconds == 0) continue;
+
+            std::string frames = token.token + "@" + std::to_string(i);
+            for (int parent = token.parent; parent >= 0; parent = statement.tokens[parent].parent) {
+                frames = statement.tokens[parent].token + "@" + std::to_string(parent) + ";" + frames;
+            }
+            out << statement.label << ";" << frames << " " << token.nanoseconds << "\n";
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#include "../include/program.h"
+#include "../include/parser.h"
+#include <sstream>
+#include <cctype>
+
+bool Statement::isLiteral() const {
+    return postfix.size() == 1 && !postfix[0].empty() &&
+           (std::isdigit(postfix[0][0]) || postfix[0][0] == '.');
+}
+
+Program::Program(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens = lexer.tokenize();
+    std::vector<Token> current;
+
+    // Split the token stream on ';' and keep each numeric declaration
+    for (const auto& token : tokens) {
+        if (token.type == TOKEN_EOF || token.value == ";") {
+            addStatement(current);
+            current.clear();
+        } else {
+            current.push_back(token);
+        }
+    }
+}
+
+bool Program::isNumericType(const std::string& type) {
+    return type == "int" || type == "float" || type == "double";
+}
+
+void Program::addStatement(const std::vector<Token>& tokens) {
+    if (tokens.size() < 4 || tokens[0].type != TOKEN_KEYWORD ||
+        !isNumericType(tokens[0].value) ||
+        tokens[1].type != TOKEN_IDENTIFIER || tokens[2].value != "=") {
+        return;
+    }
+
+    std::vector<Token> statementTokens(tokens);
+    statementTokens.push_back(Token(TOKEN_EOF, "", tokens.back().line, tokens.back().column));
+
+    Parser parser(statementTokens);
+    Statement statement;
+    statement.type = tokens[0].value;
+    statement.name = tokens[1].value;
+
+    std::istringstream iss(parser.getPostfixExpression());
+    std::string token;
+    while (iss >> token) {
+        statement.postfix.push_back(token);
+    }
+
+    if (statement.postfix.empty() || slots.find(statement.name) != slots.end()) {
+        return;
+    }
+
+    slots[statement.name] = statements.size();
+    statements.push_back(statement);
+}
+
+const std::vector<Statement>& Program::getStatements() const {
+    return statements;
+}
+
+const std::map<std::string, size_t>& Program::getSlots() const {
+    return slots;
+}
+
+std::vector<size_t> Program::getInputs() const {
+    std::vector<size_t> inputs;
+    for (size_t i = 0; i < statements.size(); ++i) {
+        if (statements[i].isLiteral()) {
+            inputs.push_back(i);
+        }
+    }
+    return inputs;
+}
+
+std::vector<ValueType> Program::getSlotTypes() const {
+    std::vector<ValueType> types;
+    for (const auto& statement : statements) {
+        types.push_back(valueTypeOf(statement.type));
+    }
+    return types;
+}
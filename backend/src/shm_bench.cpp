@@ -0,0 +1,59 @@
+#include "../include/shm_client.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Round-trip latency benchmark for a running `--daemon` instance.
+// Usage: shm_bench <name> [expression-id] [iterations]
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <name> [expression-id] [iterations]" << std::endl;
+        return 1;
+    }
+
+    try {
+        ShmClient client(argv[1]);
+        uint32_t expressionId = argc > 2 ? std::atoi(argv[2]) : client.getExpressionCount() - 1;
+        size_t iterations = argc > 3 ? std::max(1L, std::atol(argv[3])) : 1000000;
+
+        std::vector<double> values(client.getInputCount(), 1.0);
+        std::vector<long long> samples;
+        samples.reserve(iterations);
+        double result = 0;
+
+        for (size_t i = 0; i < iterations / 10 + 1; ++i) {
+            client.evaluate(expressionId, values.data(), values.size(), result);
+        }
+
+        for (size_t i = 0; i < iterations; ++i) {
+            if (!values.empty()) values[0] = static_cast<double>(i);
+            auto start = std::chrono::steady_clock::now();
+            int status = client.evaluate(expressionId, values.data(), values.size(), result);
+            auto end = std::chrono::steady_clock::now();
+            if (status != SHM_OK && status != SHM_EVAL_ERROR) {
+                std::cerr << "Request failed with status " << status << std::endl;
+                return 1;
+            }
+            samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&](double p) {
+            return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+        };
+
+        std::cout << "Round trips: " << samples.size() << "\n";
+        std::cout << "min   " << samples.front() << " ns\n";
+        std::cout << "p50   " << percentile(0.50) << " ns\n";
+        std::cout << "p99   " << percentile(0.99) << " ns\n";
+        std::cout << "p99.9 " << percentile(0.999) << " ns\n";
+        std::cout << "max   " << samples.back() << " ns\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include "../include/shm_client.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Yields between checks that the daemon process still exists
+const unsigned SHM_LIVENESS_INTERVAL = 1024;
+
+}
+
+ShmClient::ShmClient(const std::string& name) : region(nullptr), nextSequence(1) {
+    std::string path = name[0] == '/' ? name : "/" + name;
+
+    int fd = shm_open(path.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("No evaluator daemon listening on " + path);
+    }
+    void* memory = mmap(nullptr, sizeof(ShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error("Cannot map shared memory segment " + path);
+    }
+
+    region = static_cast<ShmRegion*>(memory);
+    if (region->magic != SHM_MAGIC || region->ready.load(std::memory_order_acquire) != 1) {
+        munmap(region, sizeof(ShmRegion));
+        throw std::runtime_error("Shared memory segment " + path + " is not ready");
+    }
+    // A daemon killed without cleanup leaves its segment marked ready
+    if (shmProcessGone(region->daemonPid.load(std::memory_order_acquire))) {
+        munmap(region, sizeof(ShmRegion));
+        throw std::runtime_error("No evaluator daemon listening on " + path);
+    }
+
+    // Claim the producer side; a claim left by a client that died is taken over
+    int32_t self = getpid();
+    int32_t holder = 0;
+    while (!region->clientPid.compare_exchange_strong(holder, self, std::memory_order_acq_rel)) {
+        if (!shmProcessGone(holder)) {
+            munmap(region, sizeof(ShmRegion));
+            throw std::runtime_error("Another client is attached to " + path);
+        }
+    }
+
+    // Sequences continue from the request ring, so replies to an earlier
+    // client's requests can never match ours
+    nextSequence = region->requests.tail.load(std::memory_order_acquire) + 1;
+}
+
+ShmClient::~ShmClient() {
+    region->clientPid.store(0, std::memory_order_release);
+    munmap(region, sizeof(ShmRegion));
+}
+
+void ShmClient::exchange(uint32_t expressionId, const double* values, uint32_t count,
+                         ShmResponse& response) {
+    ShmRequest request;
+    request.sequence = nextSequence++;
+    request.expressionId = expressionId;
+    request.count = count;
+    for (uint32_t i = 0; i < count; ++i) {
+        request.values[i] = values[i];
+    }
+
+    unsigned spins = 0;
+    while (!region->requests.tryPush(request)) {
+        backoff(spins);
+    }
+
+    spins = 0;
+    while (!region->responses.tryPop(response) || response.sequence != request.sequence) {
+        backoff(spins);
+    }
+}
+
+// Spin for the common fast reply, then yield so a daemon sharing our core
+// can make progress. Once spinning stops paying off, also check now and then
+// that the daemon has not died without clearing `ready`.
+void ShmClient::backoff(unsigned& spins) const {
+    if (region->ready.load(std::memory_order_relaxed) != 1) {
+        throw std::runtime_error("Evaluator daemon shut down");
+    }
+    if (++spins < shmSpinLimit()) {
+        shmCpuRelax();
+        return;
+    }
+    if ((spins - shmSpinLimit()) % SHM_LIVENESS_INTERVAL == 0 &&
+        shmProcessGone(region->daemonPid.load(std::memory_order_acquire))) {
+        throw std::runtime_error("Evaluator daemon shut down");
+    }
+    std::this_thread::yield();
+}
+
+int ShmClient::evaluate(uint32_t expressionId, const double* values, uint32_t count, double& result) {
+    if (count > SHM_MAX_VALUES) return SHM_TOO_MANY_VALUES;
+
+    ShmResponse response;
+    exchange(expressionId, values, count, response);
+    result = response.result;
+    return response.status;
+}
+
+int ShmClient::evaluate(uint32_t expressionId, const double* values, uint32_t count, int64_t& result) {
+    if (count > SHM_MAX_VALUES) return SHM_TOO_MANY_VALUES;
+
+    ShmResponse response;
+    exchange(expressionId, values, count, response);
+    if (response.status == SHM_OK && !response.isInt) return SHM_NOT_INT;
+    result = response.intResult;
+    return response.status;
+}
+
+uint32_t ShmClient::getExpressionCount() const {
+    return region->expressionCount;
+}
+
+uint32_t ShmClient::getInputCount() const {
+    return region->inputCount;
+}
@@ -0,0 +1,194 @@
+#include "../include/shm_server.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Idle daemons spin, then yield, then sleep for up to SHM_MAX_SLEEP_US
+const unsigned SHM_YIELD_LIMIT = 1024;
+const unsigned SHM_MAX_SLEEP_US = 1000;
+
+// A segment is stale when the daemon that created it is no longer running
+bool isStaleSegment(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0600);
+    if (fd < 0) return false;
+
+    struct stat info;
+    bool stale = false;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(ShmRegion)) {
+        void* memory = mmap(nullptr, sizeof(ShmRegion), PROT_READ, MAP_SHARED, fd, 0);
+        if (memory != MAP_FAILED) {
+            const ShmRegion* region = static_cast<const ShmRegion*>(memory);
+            stale = region->magic == SHM_MAGIC &&
+                    shmProcessGone(region->daemonPid.load(std::memory_order_acquire));
+            munmap(memory, sizeof(ShmRegion));
+        }
+    }
+    close(fd);
+    return stale;
+}
+
+}
+
+ShmServer::ShmServer(const std::string& name, const Program& program)
+    : name(name[0] == '/' ? name : "/" + name), region(nullptr), running(false) {
+    const std::vector<Statement>& statements = program.getStatements();
+    std::vector<ValueType> slotTypes = program.getSlotTypes();
+    std::map<std::string, size_t> visible;
+    int inputs = 0;
+
+    // Each statement may only refer to the ones declared before it
+    for (size_t i = 0; i < statements.size(); ++i) {
+        types.push_back(valueTypeOf(statements[i].type));
+        expressions.push_back(evaluator.compile(statements[i].postfix, visible, types[i], slotTypes));
+        visible[statements[i].name] = i;
+
+        // Literals are compiled like any other statement, so int defaults are exact
+        Value value = Value();
+        if (statements[i].isLiteral()) {
+            inputOrdinal.push_back(inputs++);
+            evaluator.run(expressions[i], nullptr, nullptr, value);
+        } else {
+            inputOrdinal.push_back(-1);
+        }
+        defaults.push_back(value);
+    }
+    slots = defaults;
+    slotStatus.assign(statements.size(), EVAL_OK);
+
+    // O_EXCL keeps a second daemon from resetting a channel that is in use
+    int fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST && isStaleSegment(this->name)) {
+        shm_unlink(this->name.c_str());
+        fd = shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        if (errno == EEXIST) {
+            throw std::runtime_error("Another evaluator daemon is serving " + this->name);
+        }
+        throw std::runtime_error("Cannot create shared memory segment " + this->name);
+    }
+    if (ftruncate(fd, sizeof(ShmRegion)) != 0) {
+        close(fd);
+        shm_unlink(this->name.c_str());
+        throw std::runtime_error("Cannot size shared memory segment " + this->name);
+    }
+    void* memory = mmap(nullptr, sizeof(ShmRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(this->name.c_str());
+        throw std::runtime_error("Cannot map shared memory segment " + this->name);
+    }
+
+    region = new (memory) ShmRegion;
+    region->magic = SHM_MAGIC;
+    region->expressionCount = static_cast<uint32_t>(statements.size());
+    region->inputCount = static_cast<uint32_t>(inputs);
+    region->daemonPid.store(getpid(), std::memory_order_relaxed);
+    region->clientPid.store(0, std::memory_order_relaxed);
+    region->requests.reset();
+    region->responses.reset();
+    region->ready.store(1, std::memory_order_release);
+}
+
+ShmServer::~ShmServer() {
+    if (region) {
+        region->ready.store(0, std::memory_order_release);
+        munmap(region, sizeof(ShmRegion));
+        shm_unlink(name.c_str());
+    }
+}
+
+void ShmServer::handle(const ShmRequest& request, ShmResponse& response) {
+    response.sequence = request.sequence;
+    response.isInt = 0;
+    response.result = 0;
+    response.intResult = 0;
+
+    if (request.expressionId >= expressions.size()) {
+        response.status = SHM_BAD_EXPRESSION;
+        return;
+    }
+    if (request.count > SHM_MAX_VALUES) {
+        response.status = SHM_TOO_MANY_VALUES;
+        return;
+    }
+
+    for (size_t i = 0; i <= request.expressionId; ++i) {
+        int ordinal = inputOrdinal[i];
+        if (ordinal < 0) {
+            slotStatus[i] = evaluator.run(expressions[i], slots.data(), slotStatus.data(), slots[i]);
+        } else if (static_cast<uint32_t>(ordinal) < request.count) {
+            slotStatus[i] = valueFromDouble(request.values[ordinal], types[i], slots[i]);
+        } else {
+            slots[i] = defaults[i];
+            slotStatus[i] = EVAL_OK;
+        }
+    }
+
+    uint32_t id = request.expressionId;
+    EvalStatus status = static_cast<EvalStatus>(slotStatus[id]);
+    if (status == EVAL_OK) {
+        response.status = SHM_OK;
+        response.result = valueToDouble(slots[id], types[id]);
+        response.isInt = types[id] == TYPE_INT;
+        if (response.isInt) response.intResult = slots[id].i;
+    } else {
+        response.status = SHM_EVAL_ERROR;
+        response.result = evalErrorValue(status);
+        errors.record(status);
+        if (errors.shouldSample(status)) {
+            errors.addSample(status, std::string(evalStatusName(status)) + " in expression " +
+                             std::to_string(request.expressionId) + " (request " +
+                             std::to_string(request.sequence) + ")");
+        }
+    }
+}
+
+void ShmServer::serve() {
+    ShmRequest request;
+    ShmResponse response;
+    unsigned idle = 0;
+    unsigned sleepUs = 1;
+
+    running.store(true);
+    while (running.load(std::memory_order_relaxed)) {
+        if (!region->requests.tryPop(request)) {
+            // Spin briefly to keep latency low, then stop burning the core:
+            // yield for a while and finally back off to sleeping
+            if (++idle < shmSpinLimit()) {
+                shmCpuRelax();
+            } else if (idle < shmSpinLimit() + SHM_YIELD_LIMIT) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(sleepUs));
+                sleepUs = std::min(sleepUs * 2, SHM_MAX_SLEEP_US);
+            }
+            continue;
+        }
+        idle = 0;
+        sleepUs = 1;
+
+        handle(request, response);
+        while (!region->responses.tryPush(response)) {
+            shmCpuRelax();
+        }
+    }
+}
+
+void ShmServer::stop() {
+    running.store(false);
+}
+
+const ErrorLog& ShmServer::getErrors() const {
+    return errors;
+}